@@ -0,0 +1,529 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * BLAKE2b shash driver using the generated SSE2, SSE4.1, AVX2 and AVX-512VL
+ * compress functions
+ *
+ * The backend is picked by CPU features at load time and then refined by a
+ * short calibration, similar to the lib/raid6 algorithm selection, that runs
+ * asynchronously and selects the fastest backend for each message size class.
+ */
+
+#include <asm/cpufeature.h>
+#include <asm/fpu/api.h>
+#include <linux/jiffies.h>
+#include <linux/jump_label.h>
+#include <linux/sizes.h>
+#include <linux/slab.h>
+#include <linux/static_call.h>
+#include <linux/workqueue.h>
+
+#define BLAKE2B_SIMD
+
+#include "blake2b.c"
+
+/* Limit the time spent with preemption disabled */
+#define BLAKE2B_FPU_CHUNK	SZ_4K
+
+/* Each backend is measured for 2^3 jiffies per size class */
+#define BLAKE2B_BENCH_JIFFIES_LG2	3
+
+/* The chaining value stays in registers for all nblocks */
+asmlinkage void blake2b_compress_blocks_sse2(struct blake2b_state *S,
+					     const u8 *block, size_t nblocks,
+					     u32 inc);
+asmlinkage void blake2b_compress_blocks_sse41(struct blake2b_state *S,
+					      const u8 *block, size_t nblocks,
+					      u32 inc);
+asmlinkage void blake2b_compress_blocks_avx2(struct blake2b_state *S,
+					     const u8 *block, size_t nblocks,
+					     u32 inc);
+asmlinkage void blake2b_compress_blocks_avx512vl(struct blake2b_state *S,
+						 const u8 *block, size_t nblocks,
+						 u32 inc);
+
+/* Multi-buffer batch API in blake2b-mb.c */
+void blake2b_mb_init(void);
+unsigned int blake2b_mb_nr_lanes(void);
+void blake2b_mb_update_stripes(struct blake2b_state *S, unsigned int count,
+			       const u8 *in, size_t nstripes);
+void blake2b_mb_xof_blocks(const struct blake2b_state *C, const u8 *root,
+			   u32 first, size_t nblocks, u8 *out);
+unsigned int blake2b_mb_sectors(const struct blake2b_state *init,
+				const u8 *base, size_t sector_size,
+				unsigned int count, u8 *out, const u8 *sums,
+				unsigned long *mismatch, size_t outlen);
+
+/* EVEX on ymm registers only, no zmm frequency penalty */
+static bool blake2b_avx512vl_usable(void)
+{
+	return boot_cpu_has(X86_FEATURE_AVX) && boot_cpu_has(X86_FEATURE_AVX2) &&
+	       boot_cpu_has(X86_FEATURE_AVX512F) &&
+	       boot_cpu_has(X86_FEATURE_AVX512VL) &&
+	       cpu_has_xfeatures(XFEATURE_MASK_SSE | XFEATURE_MASK_YMM |
+				 XFEATURE_MASK_AVX512, NULL);
+}
+
+static bool blake2b_avx2_usable(void)
+{
+	return boot_cpu_has(X86_FEATURE_AVX) && boot_cpu_has(X86_FEATURE_AVX2) &&
+	       cpu_has_xfeatures(XFEATURE_MASK_SSE | XFEATURE_MASK_YMM, NULL);
+}
+
+static bool blake2b_sse41_usable(void)
+{
+	return boot_cpu_has(X86_FEATURE_XMM4_1);
+}
+
+static bool blake2b_sse2_usable(void)
+{
+	return boot_cpu_has(X86_FEATURE_XMM2);
+}
+
+struct blake2b_backend {
+	const char *name;
+	const char *driver_suffix;
+	int priority;
+	blake2b_compress_t compress;
+	bool (*usable)(void);
+};
+
+/* In order of preference */
+static const struct blake2b_backend blake2b_backends[] = {
+	{ "avx512vl", "avx512vl", 500, blake2b_compress_blocks_avx512vl,
+	  blake2b_avx512vl_usable },
+	{ "avx2", "avx2", 400, blake2b_compress_blocks_avx2,
+	  blake2b_avx2_usable },
+	{ "sse41", "sse41", 300, blake2b_compress_blocks_sse41,
+	  blake2b_sse41_usable },
+	{ "sse2", "sse2", 200, blake2b_compress_blocks_sse2,
+	  blake2b_sse2_usable },
+	{ "generic", "x86_64-generic", 100, blake2b_compress_generic,
+	  NULL },
+};
+
+static bool blake2b_backend_simd(const struct blake2b_backend *b)
+{
+	return b->compress != blake2b_compress_generic;
+}
+
+enum blake2b_size_class {
+	BLAKE2B_CLASS_SMALL,
+	BLAKE2B_CLASS_MEDIUM,
+	BLAKE2B_CLASS_LARGE,
+	BLAKE2B_NR_CLASSES
+};
+
+#define BLAKE2B_SMALL_MAX	256
+#define BLAKE2B_MEDIUM_MAX	SZ_4K
+
+/* Message size used to calibrate each class */
+static const struct {
+	const char *name;
+	size_t bench_size;
+} blake2b_classes[BLAKE2B_NR_CLASSES] = {
+	[BLAKE2B_CLASS_SMALL]	= { "small", BLAKE2B_SMALL_MAX },
+	[BLAKE2B_CLASS_MEDIUM]	= { "medium", SZ_2K },
+	[BLAKE2B_CLASS_LARGE]	= { "large", SZ_16K },
+};
+
+/* Updates are routed by their length, final goes through the small class */
+DEFINE_STATIC_CALL(blake2b_compress_small, blake2b_compress_blocks_sse2);
+DEFINE_STATIC_CALL(blake2b_compress_medium, blake2b_compress_blocks_sse2);
+DEFINE_STATIC_CALL(blake2b_compress_large, blake2b_compress_blocks_sse2);
+static DEFINE_STATIC_KEY_ARRAY_FALSE(blake2b_use_simd, BLAKE2B_NR_CLASSES);
+
+static const struct blake2b_backend *blake2b_selected[BLAKE2B_NR_CLASSES];
+
+static char *backend;
+module_param(backend, charp, 0444);
+MODULE_PARM_DESC(backend, "Force the compress backend: avx512vl, avx2, sse41, sse2 or generic");
+
+static int blake2b_selection_get(char *buf, const struct kernel_param *kp)
+{
+	int len = 0;
+	int i;
+
+	for (i = 0; i < BLAKE2B_NR_CLASSES; i++)
+		len += sysfs_emit_at(buf, len, "%s%s=%s", i ? " " : "",
+				     blake2b_classes[i].name,
+				     READ_ONCE(blake2b_selected[i])->name);
+	len += sysfs_emit_at(buf, len, "\n");
+	return len;
+}
+
+static const struct kernel_param_ops blake2b_selection_ops = {
+	.get = blake2b_selection_get,
+};
+module_param_cb(selection, &blake2b_selection_ops, NULL, 0444);
+MODULE_PARM_DESC(selection, "Compress backend used for small, medium and large messages");
+
+static __always_inline void blake2b_compress_small_arch(struct blake2b_state *S,
+							const u8 *block,
+							size_t nblocks, u32 inc)
+{
+	static_call(blake2b_compress_small)(S, block, nblocks, inc);
+}
+
+static __always_inline void blake2b_compress_medium_arch(struct blake2b_state *S,
+							 const u8 *block,
+							 size_t nblocks, u32 inc)
+{
+	static_call(blake2b_compress_medium)(S, block, nblocks, inc);
+}
+
+static __always_inline void blake2b_compress_large_arch(struct blake2b_state *S,
+							const u8 *block,
+							size_t nblocks, u32 inc)
+{
+	static_call(blake2b_compress_large)(S, block, nblocks, inc);
+}
+
+static __always_inline void blake2b_update_simd(struct blake2b_state *S,
+						const u8 *in, size_t inlen,
+						blake2b_compress_t compress)
+{
+	while (inlen > 0) {
+		size_t chunk = min_t(size_t, inlen, BLAKE2B_FPU_CHUNK);
+
+		kernel_fpu_begin();
+		__blake2b_update(S, in, chunk, compress);
+		kernel_fpu_end();
+		in += chunk;
+		inlen -= chunk;
+	}
+}
+
+static __always_inline int blake2b_final_simd(struct blake2b_state *S,
+					      void *out, size_t outlen,
+					      blake2b_compress_t compress)
+{
+	int ret;
+
+	kernel_fpu_begin();
+	ret = __blake2b_final(S, out, outlen, compress);
+	kernel_fpu_end();
+	return ret;
+}
+
+/* All but the last FPU chunk go through update, the tail is one-shot */
+static __always_inline int blake2b_finup_simd(struct blake2b_state *S,
+					      const u8 *in, size_t inlen,
+					      u8 *out, blake2b_compress_t compress)
+{
+	int ret;
+
+	if (inlen > BLAKE2B_FPU_CHUNK) {
+		size_t head = round_down(inlen - 1, BLAKE2B_FPU_CHUNK);
+
+		blake2b_update_simd(S, in, head, compress);
+		in += head;
+		inlen -= head;
+	}
+
+	kernel_fpu_begin();
+	ret = __blake2b_finup(S, in, inlen, out, compress);
+	kernel_fpu_end();
+	return ret;
+}
+
+static int blake2b_update_arch(struct blake2b_state *S, const void *pin,
+			       size_t inlen)
+{
+	if (!irq_fpu_usable())
+		return blake2b_update(S, pin, inlen);
+
+	if (inlen <= BLAKE2B_SMALL_MAX) {
+		if (!static_branch_likely(&blake2b_use_simd[BLAKE2B_CLASS_SMALL]))
+			return blake2b_update(S, pin, inlen);
+		blake2b_update_simd(S, pin, inlen, blake2b_compress_small_arch);
+	} else if (inlen <= BLAKE2B_MEDIUM_MAX) {
+		if (!static_branch_likely(&blake2b_use_simd[BLAKE2B_CLASS_MEDIUM]))
+			return blake2b_update(S, pin, inlen);
+		blake2b_update_simd(S, pin, inlen, blake2b_compress_medium_arch);
+	} else {
+		if (!static_branch_likely(&blake2b_use_simd[BLAKE2B_CLASS_LARGE]))
+			return blake2b_update(S, pin, inlen);
+		blake2b_update_simd(S, pin, inlen, blake2b_compress_large_arch);
+	}
+	return 0;
+}
+
+static int blake2b_final_arch(struct blake2b_state *S, void *out, size_t outlen)
+{
+	if (!static_branch_likely(&blake2b_use_simd[BLAKE2B_CLASS_SMALL]) ||
+	    !irq_fpu_usable())
+		return blake2b_final(S, out, outlen);
+
+	return blake2b_final_simd(S, out, outlen, blake2b_compress_small_arch);
+}
+
+static int blake2b_finup_arch(struct blake2b_state *S, const u8 *in,
+			      size_t inlen, u8 *out)
+{
+	if (!irq_fpu_usable())
+		return blake2b_finup(S, in, inlen, out);
+
+	if (inlen <= BLAKE2B_SMALL_MAX) {
+		if (!static_branch_likely(&blake2b_use_simd[BLAKE2B_CLASS_SMALL]))
+			return blake2b_finup(S, in, inlen, out);
+		return blake2b_finup_simd(S, in, inlen, out,
+					  blake2b_compress_small_arch);
+	} else if (inlen <= BLAKE2B_MEDIUM_MAX) {
+		if (!static_branch_likely(&blake2b_use_simd[BLAKE2B_CLASS_MEDIUM]))
+			return blake2b_finup(S, in, inlen, out);
+		return blake2b_finup_simd(S, in, inlen, out,
+					  blake2b_compress_medium_arch);
+	}
+	if (!static_branch_likely(&blake2b_use_simd[BLAKE2B_CLASS_LARGE]))
+		return blake2b_finup(S, in, inlen, out);
+	return blake2b_finup_simd(S, in, inlen, out, blake2b_compress_large_arch);
+}
+
+/* BLAKE2bp leaves on the multi-buffer lanes, the finalization is serial */
+static void blake2bp_stripes_arch(struct blake2b_state *S, const u8 *in,
+				  size_t nstripes)
+{
+	if (!blake2b_mb_nr_lanes() || !irq_fpu_usable())
+		return blake2bp_stripes_generic(S, in, nstripes);
+
+	blake2b_mb_update_stripes(S, BLAKE2BP_LEAVES, in, nstripes);
+}
+
+static int blake2bp_update_arch(struct blake2bp_state *S, const void *pin,
+				size_t inlen)
+{
+	return __blake2bp_update(S, pin, inlen, blake2bp_stripes_arch);
+}
+
+static int blake2bp_final_arch(struct blake2bp_state *S, void *out,
+			       size_t outlen)
+{
+	return __blake2bp_final(S, out, outlen, blake2b_update_arch,
+				blake2b_final_arch);
+}
+
+/* BLAKE2Xb output blocks on the multi-buffer lanes */
+static void blake2xb_blocks_arch(const struct blake2b_state *C,
+				 const u8 *root, u32 first, size_t nblocks,
+				 u8 *out)
+{
+	if (nblocks < 2 || !blake2b_mb_nr_lanes() || !irq_fpu_usable())
+		return __blake2xb_blocks(C, root, first, nblocks, out,
+					  blake2b_update_arch,
+					  blake2b_final_arch);
+
+	blake2b_mb_xof_blocks(C, root, first, nblocks, out);
+}
+
+/*
+ * The generic path never goes through the static calls, so the key and the
+ * call can be switched in any order while hashing is in progress.
+ */
+static void blake2b_bind(enum blake2b_size_class class,
+			 const struct blake2b_backend *b)
+{
+	switch (class) {
+	case BLAKE2B_CLASS_SMALL:
+		static_call_update(blake2b_compress_small, b->compress);
+		break;
+	case BLAKE2B_CLASS_MEDIUM:
+		static_call_update(blake2b_compress_medium, b->compress);
+		break;
+	case BLAKE2B_CLASS_LARGE:
+		static_call_update(blake2b_compress_large, b->compress);
+		break;
+	default:
+		return;
+	}
+
+	if (blake2b_backend_simd(b))
+		static_branch_enable(&blake2b_use_simd[class]);
+	else
+		static_branch_disable(&blake2b_use_simd[class]);
+	WRITE_ONCE(blake2b_selected[class], b);
+}
+
+/*
+ * Messages of @len bytes hashed during the measurement interval. The live
+ * static calls are left alone, @b is called through its pointer. That costs
+ * every candidate the same, so the ranking holds.
+ */
+static unsigned long blake2b_bench(const struct blake2b_backend *b,
+				   const u8 *buf, size_t len)
+{
+	struct blake2b_state S[1];
+	u8 out[BLAKE2B_OUTBYTES];
+	unsigned long perf = 0;
+	unsigned long j0, j1;
+
+	preempt_disable();
+	j0 = jiffies;
+	while ((j1 = jiffies) == j0)
+		cpu_relax();
+	while (time_before(jiffies, j1 + (1 << BLAKE2B_BENCH_JIFFIES_LG2))) {
+		blake2b_init(S, BLAKE2B_OUTBYTES);
+		if (blake2b_backend_simd(b))
+			blake2b_finup_simd(S, buf, len, out, b->compress);
+		else
+			__blake2b_finup(S, buf, len, out, b->compress);
+		perf++;
+	}
+	preempt_enable();
+
+	return perf;
+}
+
+static void blake2b_calibrate(struct work_struct *work)
+{
+	const struct blake2b_backend *b, *best;
+	unsigned long perf, bestperf;
+	size_t len;
+	u8 *buf;
+	int class;
+	int i;
+
+	buf = kmalloc(SZ_16K, GFP_KERNEL);
+	if (!buf)
+		return;
+	for (i = 0; i < SZ_16K; i++)
+		buf[i] = (u8)(i * 7 + 3);
+
+	for (class = 0; class < BLAKE2B_NR_CLASSES; class++) {
+		len = blake2b_classes[class].bench_size;
+		best = NULL;
+		bestperf = 0;
+		for (i = 0; i < ARRAY_SIZE(blake2b_backends); i++) {
+			b = &blake2b_backends[i];
+			if (b->usable && !b->usable())
+				continue;
+
+			perf = blake2b_bench(b, buf, len);
+			pr_info("blake2b: %-7s %-6s %5lu MB/s\n", b->name,
+				blake2b_classes[class].name,
+				(perf * len * HZ) >> (20 + BLAKE2B_BENCH_JIFFIES_LG2));
+			if (perf > bestperf) {
+				bestperf = perf;
+				best = b;
+			}
+		}
+		if (best) {
+			pr_info("blake2b: using %s for %s messages\n",
+				best->name, blake2b_classes[class].name);
+			blake2b_bind(class, best);
+		}
+	}
+
+	kfree(buf);
+}
+
+static DECLARE_WORK(blake2b_calibrate_work, blake2b_calibrate);
+
+#include "blake2b-mb-ahash.c"
+#include "blake2b-sg-ahash.c"
+#include "blake2b-tree.c"
+#include "blake2b-merkle.c"
+#include "blake2b-verity.c"
+
+static int __init blake2b_arch_init(struct shash_alg *algs, int count)
+{
+	const struct blake2b_backend *b;
+	int class;
+	int ret;
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(blake2b_backends); i++) {
+		b = &blake2b_backends[i];
+		if (backend && strcmp(backend, b->name))
+			continue;
+		if (b->usable && !b->usable()) {
+			if (backend) {
+				pr_err("blake2b: backend %s not supported by the CPU\n",
+				       backend);
+				return -ENODEV;
+			}
+			continue;
+		}
+		break;
+	}
+	if (i == ARRAY_SIZE(blake2b_backends)) {
+		pr_err("blake2b: unknown backend %s\n", backend);
+		return -EINVAL;
+	}
+
+	for (class = 0; class < BLAKE2B_NR_CLASSES; class++)
+		blake2b_bind(class, b);
+	blake2b_mb_init();
+	ret = blake2b_tree_init();
+	if (ret)
+		return ret;
+	ret = blake2b_mb_register();
+	if (ret) {
+		blake2b_tree_exit();
+		return ret;
+	}
+
+	for (i = 0; i < count; i++) {
+		snprintf(algs[i].base.cra_driver_name, CRYPTO_MAX_ALG_NAME,
+			 "%s-%s", algs[i].base.cra_name, b->driver_suffix);
+		algs[i].base.cra_priority = b->priority;
+	}
+
+	/* BLAKE2bp is named after the multi-buffer kernel of its leaves */
+	if (blake2b_mb_nr_lanes())
+		blake2bp_alg.halg.base.cra_priority = 300;
+	snprintf(blake2bp_alg.halg.base.cra_driver_name, CRYPTO_MAX_ALG_NAME,
+		 "blake2bp-%s", blake2b_mb_nr_lanes() == 8 ? "avx512" :
+				blake2b_mb_nr_lanes() == 4 ? "avx2" :
+				"x86_64-generic");
+
+	ret = blake2b_sg_register(b);
+	if (ret) {
+		blake2b_mb_unregister();
+		blake2b_tree_exit();
+		return ret;
+	}
+
+	/* A forced backend is used for all sizes */
+	if (!backend)
+		queue_work(system_unbound_wq, &blake2b_calibrate_work);
+	return 0;
+}
+
+static void blake2b_arch_exit(void)
+{
+	cancel_work_sync(&blake2b_calibrate_work);
+	blake2b_sg_unregister();
+	blake2b_mb_unregister();
+	blake2b_tree_exit();
+}
+
+MODULE_DESCRIPTION("BLAKE2b SIMD implementation");
+MODULE_ALIAS_CRYPTO("blake2b-avx512vl");
+MODULE_ALIAS_CRYPTO("blake2b-mb");
+MODULE_ALIAS_CRYPTO("blake2b-sg-avx512vl");
+MODULE_ALIAS_CRYPTO("blake2b-sg-avx2");
+MODULE_ALIAS_CRYPTO("blake2b-sg-sse41");
+MODULE_ALIAS_CRYPTO("blake2b-sg-sse2");
+MODULE_ALIAS_CRYPTO("blake2b-sg-x86_64-generic");
+MODULE_ALIAS_CRYPTO("blake2bp-avx512");
+MODULE_ALIAS_CRYPTO("blake2bp-avx2");
+MODULE_ALIAS_CRYPTO("blake2bp-x86_64-generic");
+MODULE_ALIAS_CRYPTO("blake2b-avx2");
+MODULE_ALIAS_CRYPTO("blake2b-sse41");
+MODULE_ALIAS_CRYPTO("blake2b-sse2");
+MODULE_ALIAS_CRYPTO("blake2b-x86_64-generic");
+MODULE_ALIAS_CRYPTO("blake2b-160-avx512vl");
+MODULE_ALIAS_CRYPTO("blake2b-160-avx2");
+MODULE_ALIAS_CRYPTO("blake2b-160-sse41");
+MODULE_ALIAS_CRYPTO("blake2b-160-sse2");
+MODULE_ALIAS_CRYPTO("blake2b-160-x86_64-generic");
+MODULE_ALIAS_CRYPTO("blake2b-256-avx512vl");
+MODULE_ALIAS_CRYPTO("blake2b-256-avx2");
+MODULE_ALIAS_CRYPTO("blake2b-256-sse41");
+MODULE_ALIAS_CRYPTO("blake2b-256-sse2");
+MODULE_ALIAS_CRYPTO("blake2b-256-x86_64-generic");
+MODULE_ALIAS_CRYPTO("blake2b-384-avx512vl");
+MODULE_ALIAS_CRYPTO("blake2b-384-avx2");
+MODULE_ALIAS_CRYPTO("blake2b-384-sse41");
+MODULE_ALIAS_CRYPTO("blake2b-384-sse2");
+MODULE_ALIAS_CRYPTO("blake2b-384-x86_64-generic");
@@ -0,0 +1,282 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * Asynchronous BLAKE2b driver blake2b-mb feeding the multi-buffer kernels,
+ * included by blake2b-glue.c
+ *
+ * One-shot digest requests are collected in a per-CPU queue. A queue that
+ * has as many requests as the kernel has lanes is hashed right away by the
+ * submitter of the last one, a partial queue is flushed from a delayed work
+ * after flush_usecs. A source spread over several scatterlist entries is
+ * copied into a bounce buffer, the lanes need each message in one piece. A
+ * request that may not sleep gets it from kmalloc() only, if that fails it
+ * is hashed synchronously. Everything else is hashed synchronously with the
+ * same code as the shash, which stays the low latency choice.
+ */
+
+#include <linux/list.h>
+#include <linux/percpu.h>
+#include <linux/scatterlist.h>
+#include <linux/slab.h>
+#include <linux/spinlock.h>
+
+static unsigned int flush_usecs = 100;
+module_param(flush_usecs, uint, 0644);
+MODULE_PARM_DESC(flush_usecs, "Deadline for a partially filled blake2b-mb lane group, rounded up to jiffies");
+
+struct blake2b_mb_queue {
+	spinlock_t lock;
+	struct list_head reqs;
+	unsigned int count;
+	struct delayed_work flush;
+};
+
+static DEFINE_PER_CPU(struct blake2b_mb_queue, blake2b_mb_queues);
+
+struct blake2b_mb_reqctx {
+	struct list_head list;
+	struct ahash_request *req;
+	const u8 *data;
+	u8 *bounce;		/* data, if the source is fragmented */
+	struct blake2b_state S[1];
+};
+
+static int blake2b_mb_init_req(struct ahash_request *req)
+{
+	struct blake2b_mb_reqctx *rctx = ahash_request_ctx(req);
+
+	blake2b_init(rctx->S, BLAKE2B_OUTBYTES);
+	return 0;
+}
+
+static int blake2b_mb_update(struct ahash_request *req)
+{
+	struct blake2b_mb_reqctx *rctx = ahash_request_ctx(req);
+	struct crypto_hash_walk walk;
+	int nbytes;
+
+	for (nbytes = crypto_hash_walk_first(req, &walk); nbytes > 0;
+	     nbytes = crypto_hash_walk_done(&walk, 0))
+		blake2b_update_arch(rctx->S, walk.data, nbytes);
+
+	return nbytes;
+}
+
+static int blake2b_mb_final(struct ahash_request *req)
+{
+	struct blake2b_mb_reqctx *rctx = ahash_request_ctx(req);
+
+	if (blake2b_final_arch(rctx->S, req->result, BLAKE2B_OUTBYTES))
+		return -EINVAL;
+	return 0;
+}
+
+static int blake2b_mb_finup(struct ahash_request *req)
+{
+	int ret;
+
+	ret = blake2b_mb_update(req);
+	if (ret)
+		return ret;
+	return blake2b_mb_final(req);
+}
+
+static int blake2b_mb_export(struct ahash_request *req, void *out)
+{
+	struct blake2b_mb_reqctx *rctx = ahash_request_ctx(req);
+
+	blake2b_export_state(rctx->S, out);
+	return 0;
+}
+
+static int blake2b_mb_import(struct ahash_request *req, const void *in)
+{
+	struct blake2b_mb_reqctx *rctx = ahash_request_ctx(req);
+
+	return blake2b_import_state(rctx->S, in, BLAKE2B_OUTBYTES);
+}
+
+/* Hash a lane group, all requests but self are completed by callback */
+static void blake2b_mb_run(struct list_head *batch, struct ahash_request *self)
+{
+	u8 digests[BLAKE2B_MB_LANES][BLAKE2B_OUTBYTES];
+	struct ahash_request *reqs[BLAKE2B_MB_LANES];
+	const u8 *data[BLAKE2B_MB_LANES];
+	size_t len[BLAKE2B_MB_LANES];
+	u8 *bounce[BLAKE2B_MB_LANES];
+	struct blake2b_mb_reqctx *rctx, *tmp;
+	unsigned int n = 0;
+	unsigned int i;
+
+	list_for_each_entry_safe(rctx, tmp, batch, list) {
+		list_del(&rctx->list);
+		reqs[n] = rctx->req;
+		data[n] = rctx->data;
+		len[n] = reqs[n]->nbytes;
+		bounce[n] = rctx->bounce;
+		n++;
+	}
+
+	blake2b_digest_many(n, data, len, digests[0], BLAKE2B_OUTBYTES);
+	for (i = 0; i < n; i++)
+		kvfree_sensitive(bounce[i], len[i]);
+
+	for (i = 0; i < n; i++) {
+		memcpy(reqs[i]->result, digests[i], BLAKE2B_OUTBYTES);
+		if (reqs[i] == self)
+			continue;
+		local_bh_disable();
+		ahash_request_complete(reqs[i], 0);
+		local_bh_enable();
+	}
+	memzero_explicit(digests, sizeof(digests));
+}
+
+static void blake2b_mb_flush(struct work_struct *work)
+{
+	struct blake2b_mb_queue *q = container_of(to_delayed_work(work),
+						  struct blake2b_mb_queue,
+						  flush);
+	LIST_HEAD(batch);
+
+	spin_lock_bh(&q->lock);
+	list_splice_init(&q->reqs, &batch);
+	q->count = 0;
+	spin_unlock_bh(&q->lock);
+
+	if (!list_empty(&batch))
+		blake2b_mb_run(&batch, NULL);
+}
+
+/* Copy a source spread over several scatterlist entries into one buffer */
+static int blake2b_mb_bounce(struct ahash_request *req)
+{
+	struct blake2b_mb_reqctx *rctx = ahash_request_ctx(req);
+	struct sg_mapping_iter miter;
+	size_t off = 0;
+	size_t len;
+
+	/* The vmalloc fallback needs to sleep */
+	if (req->base.flags & CRYPTO_TFM_REQ_MAY_SLEEP)
+		rctx->bounce = kvmalloc(req->nbytes, GFP_KERNEL);
+	else
+		rctx->bounce = kmalloc(req->nbytes, GFP_ATOMIC);
+	if (!rctx->bounce)
+		return -ENOMEM;
+
+	sg_miter_start(&miter, req->src, sg_nents(req->src),
+		       SG_MITER_FROM_SG | SG_MITER_ATOMIC);
+	while (off < req->nbytes && sg_miter_next(&miter)) {
+		len = min_t(size_t, miter.length, req->nbytes - off);
+		memcpy(rctx->bounce + off, miter.addr, len);
+		miter.consumed = len;
+		off += len;
+	}
+	sg_miter_stop(&miter);
+
+	if (off < req->nbytes) {
+		kvfree_sensitive(rctx->bounce, req->nbytes);
+		rctx->bounce = NULL;
+		return -EINVAL;
+	}
+	return 0;
+}
+
+static int blake2b_mb_digest(struct ahash_request *req)
+{
+	struct blake2b_mb_reqctx *rctx = ahash_request_ctx(req);
+	struct blake2b_mb_queue *q;
+	LIST_HEAD(batch);
+
+	rctx->req = req;
+	rctx->bounce = NULL;
+	rctx->data = req->nbytes ? sg_virt(req->src) : NULL;
+	if (req->nbytes && req->nbytes > req->src->length) {
+		/* Hashed synchronously if there is no memory for the copy */
+		if (blake2b_mb_bounce(req)) {
+			blake2b_mb_init_req(req);
+			return blake2b_mb_finup(req);
+		}
+		rctx->data = rctx->bounce;
+	}
+
+	local_bh_disable();
+	q = this_cpu_ptr(&blake2b_mb_queues);
+	spin_lock(&q->lock);
+	list_add_tail(&rctx->list, &q->reqs);
+	if (++q->count < blake2b_mb_nr_lanes()) {
+		if (q->count == 1)
+			mod_delayed_work_on(smp_processor_id(), system_wq,
+					    &q->flush,
+					    usecs_to_jiffies(READ_ONCE(flush_usecs)));
+		spin_unlock(&q->lock);
+		local_bh_enable();
+		return -EINPROGRESS;
+	}
+	list_splice_init(&q->reqs, &batch);
+	q->count = 0;
+	spin_unlock(&q->lock);
+	local_bh_enable();
+
+	blake2b_mb_run(&batch, req);
+	return 0;
+}
+
+static int blake2b_mb_init_tfm(struct crypto_ahash *tfm)
+{
+	crypto_ahash_set_reqsize(tfm, sizeof(struct blake2b_mb_reqctx));
+	return 0;
+}
+
+static struct ahash_alg blake2b_mb_alg = {
+	.init		=	blake2b_mb_init_req,
+	.update		=	blake2b_mb_update,
+	.final		=	blake2b_mb_final,
+	.finup		=	blake2b_mb_finup,
+	.digest		=	blake2b_mb_digest,
+	.export		=	blake2b_mb_export,
+	.import		=	blake2b_mb_import,
+	.init_tfm	=	blake2b_mb_init_tfm,
+	.halg		=	{
+		.digestsize	=	BLAKE2B_OUTBYTES,
+		.statesize	=	sizeof(struct chksum_export_state),
+		.base		=	{
+			.cra_name		=	"blake2b",
+			.cra_driver_name	=	"blake2b-mb",
+			/* Only on request, below the shash drivers */
+			.cra_priority		=	50,
+			.cra_flags		=	CRYPTO_ALG_ASYNC,
+			.cra_blocksize		=	1,
+			.cra_module		=	THIS_MODULE,
+		}
+	}
+};
+
+static int __init blake2b_mb_register(void)
+{
+	struct blake2b_mb_queue *q;
+	int cpu;
+
+	if (!blake2b_mb_nr_lanes())
+		return 0;
+
+	for_each_possible_cpu(cpu) {
+		q = per_cpu_ptr(&blake2b_mb_queues, cpu);
+		spin_lock_init(&q->lock);
+		INIT_LIST_HEAD(&q->reqs);
+		INIT_DELAYED_WORK(&q->flush, blake2b_mb_flush);
+	}
+	return crypto_register_ahash(&blake2b_mb_alg);
+}
+
+static void blake2b_mb_unregister(void)
+{
+	int cpu;
+
+	if (!blake2b_mb_nr_lanes())
+		return;
+
+	crypto_unregister_ahash(&blake2b_mb_alg);
+	/* Queued requests still get their completion */
+	for_each_possible_cpu(cpu)
+		flush_delayed_work(&per_cpu_ptr(&blake2b_mb_queues, cpu)->flush);
+}
@@ -0,0 +1,671 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * Multi-buffer BLAKE2b, independent messages hashed in parallel with one
+ * message per SIMD lane
+ *
+ * Messages are assigned to lanes in order, a lane that has compressed its
+ * last block is refilled with the next message and lanes left without one
+ * are masked off in the kernel.
+ */
+
+#include <asm/cpufeature.h>
+#include <asm/fpu/api.h>
+#include <crypto/algapi.h>
+#include <linux/bitmap.h>
+#include <linux/bits.h>
+#include <linux/export.h>
+#include <linux/kernel.h>
+#include <linux/string.h>
+
+#include "blake2.h"
+#include "blake2-impl.h"
+
+/* Lane blocks compressed per FPU section */
+#define BLAKE2B_MB_FPU_BLOCKS	32
+
+typedef void (*blake2b_mb_compress_t)(struct blake2b_mb_state *S,
+				      const u8 *const block[], u32 mask);
+
+asmlinkage void blake2b_compress_mb4_avx2(struct blake2b_mb_state *S,
+					  const u8 *const block[], u32 mask);
+asmlinkage void blake2b_compress_mb8_avx512(struct blake2b_mb_state *S,
+					    const u8 *const block[], u32 mask);
+
+typedef void (*blake2b_mb_bcast_t)(struct blake2b_mb_state *S, const u8 *in,
+				   size_t nblocks, u32 mask);
+
+asmlinkage void blake2b_compress_mb4_bcast_avx2(struct blake2b_mb_state *S,
+						const u8 *in, size_t nblocks,
+						u32 mask);
+asmlinkage void blake2b_compress_mb8_bcast_avx512(struct blake2b_mb_state *S,
+						  const u8 *in, size_t nblocks,
+						  u32 mask);
+
+static blake2b_mb_compress_t blake2b_mb_compress __ro_after_init;
+static blake2b_mb_bcast_t blake2b_mb_bcast __ro_after_init;
+static unsigned int blake2b_mb_lanes __ro_after_init;
+
+/* Readable block for the masked off lanes */
+static const u8 blake2b_mb_zero[BLAKE2B_BLOCKBYTES];
+
+struct blake2b_mb_lane {
+	const u8 *in;
+	size_t left;
+	unsigned int msg;
+};
+
+static void blake2b_mb_start(struct blake2b_mb_state *S,
+			     struct blake2b_mb_lane *lane, unsigned int l,
+			     const struct blake2b_state *init,
+			     const u8 *const data[], const size_t len[],
+			     unsigned int msg)
+{
+	int i;
+
+	for (i = 0; i < 8; i++)
+		S->h[i][l] = init->h[i];
+	S->t[l] = 0;
+	S->f[l] = 0;
+	lane->in = data[msg];
+	lane->left = len[msg];
+	lane->msg = msg;
+}
+
+static void blake2b_mb_output(const struct blake2b_mb_state *S,
+			      unsigned int l, u8 *out, size_t outlen)
+{
+	u8 buffer[BLAKE2B_OUTBYTES];
+	size_t i;
+
+	for (i = 0; i < DIV_ROUND_UP(outlen, sizeof(u64)); i++)
+		store64(buffer + sizeof(u64) * i, S->h[i][l]);
+
+	memcpy(out, buffer, outlen);
+}
+
+static void blake2b_mb_hash(unsigned int n, const u8 *const data[],
+			    const size_t len[], u8 *out, size_t outlen)
+{
+	const unsigned int lanes = blake2b_mb_lanes;
+	struct blake2b_mb_lane lane[BLAKE2B_MB_LANES];
+	u8 tail[BLAKE2B_MB_LANES][BLAKE2B_BLOCKBYTES];
+	const u8 *block[BLAKE2B_MB_LANES];
+	struct blake2b_mb_state S;
+	struct blake2b_state init;
+	unsigned int next = 0;
+	unsigned int nr = 0;
+	u32 active = 0;
+	u32 last;
+	unsigned int l;
+
+	/* IV xor the parameter block, the same for all messages */
+	blake2b_init(&init, outlen);
+
+	for (l = 0; l < lanes && next < n; l++, next++) {
+		blake2b_mb_start(&S, &lane[l], l, &init, data, len, next);
+		active |= BIT(l);
+	}
+
+	kernel_fpu_begin();
+	while (active) {
+		last = 0;
+		for (l = 0; l < lanes; l++) {
+			struct blake2b_mb_lane *L = &lane[l];
+
+			if (!(active & BIT(l))) {
+				block[l] = blake2b_mb_zero;
+				continue;
+			}
+			if (L->left > BLAKE2B_BLOCKBYTES) {
+				block[l] = L->in;
+				S.t[l] += BLAKE2B_BLOCKBYTES;
+				L->in += BLAKE2B_BLOCKBYTES;
+				L->left -= BLAKE2B_BLOCKBYTES;
+				continue;
+			}
+
+			/* Last block, only a partial one is padded */
+			if (L->left == BLAKE2B_BLOCKBYTES) {
+				block[l] = L->in;
+			} else {
+				memcpy(tail[l], L->in, L->left);
+				memset(tail[l] + L->left, 0,
+				       BLAKE2B_BLOCKBYTES - L->left);
+				block[l] = tail[l];
+			}
+			S.t[l] += L->left;
+			S.f[l] = (u64)-1;
+			last |= BIT(l);
+		}
+
+		blake2b_mb_compress(&S, block, active);
+
+		for (l = 0; l < lanes; l++) {
+			if (!(last & BIT(l)))
+				continue;
+			blake2b_mb_output(&S, l, out + lane[l].msg * outlen,
+					  outlen);
+			if (next < n)
+				blake2b_mb_start(&S, &lane[l], l, &init, data,
+						 len, next++);
+			else
+				active &= ~BIT(l);
+		}
+
+		if (++nr == BLAKE2B_MB_FPU_BLOCKS && active) {
+			kernel_fpu_end();
+			kernel_fpu_begin();
+			nr = 0;
+		}
+	}
+	kernel_fpu_end();
+
+	memzero_explicit(tail, sizeof(tail));
+	memzero_explicit(&S, sizeof(S));
+}
+
+/**
+ * blake2b_digest_many - unkeyed BLAKE2b digests of independent messages
+ * @n: number of messages
+ * @data: the messages
+ * @len: length of each message
+ * @out: n digests of outlen bytes, in the order of the messages
+ * @outlen: digest length, 1 to BLAKE2B_OUTBYTES
+ *
+ * The messages are spread over the lanes of the multi-buffer kernel when the
+ * CPU has one and the FPU is usable, otherwise they are hashed one by one.
+ */
+int blake2b_digest_many(unsigned int n, const u8 *const data[],
+			const size_t len[], u8 *out, size_t outlen)
+{
+	struct blake2b_state S;
+	unsigned int i;
+
+	if (!outlen || outlen > BLAKE2B_OUTBYTES)
+		return -EINVAL;
+
+	if (blake2b_mb_compress && irq_fpu_usable()) {
+		blake2b_mb_hash(n, data, len, out, outlen);
+		return 0;
+	}
+
+	for (i = 0; i < n; i++) {
+		blake2b_init(&S, outlen);
+		blake2b_update(&S, data[i], len[i]);
+		blake2b_final(&S, out + i * outlen, outlen);
+	}
+	return 0;
+}
+EXPORT_SYMBOL_GPL(blake2b_digest_many);
+
+/* Store the digest of sector i, or compare it with the stored checksum */
+static unsigned int blake2b_sector_out(const u8 *digest, unsigned int i,
+				       u8 *out, const u8 *sums,
+				       unsigned long *mismatch, size_t outlen)
+{
+	if (out) {
+		memcpy(out + i * outlen, digest, outlen);
+		return 0;
+	}
+	if (!crypto_memneq(digest, sums + i * outlen, outlen))
+		return 0;
+	__set_bit(i, mismatch);
+	return 1;
+}
+
+/* Called after each lane compress, bounds the FPU section */
+static void blake2b_mb_yield(unsigned int *nr)
+{
+	if (++*nr >= BLAKE2B_MB_FPU_BLOCKS) {
+		kernel_fpu_end();
+		kernel_fpu_begin();
+		*nr = 0;
+	}
+}
+
+/*
+ * Sectors of the same size run in lockstep, one per lane. A block buffered
+ * in init, the key or a salt, is compressed once on lane 0 and its chaining
+ * value starts every sector.
+ */
+unsigned int blake2b_mb_sectors(const struct blake2b_state *init,
+				const u8 *base, size_t sector_size,
+				unsigned int count, u8 *out, const u8 *sums,
+				unsigned long *mismatch, size_t outlen)
+{
+	const unsigned int lanes = blake2b_mb_lanes;
+	u8 tail[BLAKE2B_MB_LANES][BLAKE2B_BLOCKBYTES];
+	const u8 *block[BLAKE2B_MB_LANES];
+	u8 digest[BLAKE2B_OUTBYTES];
+	struct blake2b_mb_state M;
+	u64 h[8], t0 = 0;
+	unsigned int errors = 0;
+	unsigned int nr = 0;
+	unsigned int first, count_l, l;
+	size_t left;
+	int i;
+
+	for (l = 0; l < lanes; l++)
+		block[l] = blake2b_mb_zero;
+	for (i = 0; i < 8; i++)
+		h[i] = init->h[i];
+	/* The kernel loads the lanes that are masked off too */
+	memset(&M, 0, sizeof(M));
+
+	kernel_fpu_begin();
+	if (init->buflen) {
+		for (i = 0; i < 8; i++)
+			M.h[i][0] = h[i];
+		M.t[0] = BLAKE2B_BLOCKBYTES;
+		M.f[0] = 0;
+		block[0] = init->buf;
+		blake2b_mb_compress(&M, block, 1);
+		blake2b_mb_yield(&nr);
+		for (i = 0; i < 8; i++)
+			h[i] = M.h[i][0];
+		t0 = BLAKE2B_BLOCKBYTES;
+	}
+
+	for (first = 0; first < count; first += count_l) {
+		count_l = min(count - first, lanes);
+		for (l = 0; l < count_l; l++) {
+			for (i = 0; i < 8; i++)
+				M.h[i][l] = h[i];
+			M.t[l] = t0;
+			M.f[l] = 0;
+			block[l] = base + (size_t)(first + l) * sector_size;
+		}
+		for (; l < lanes; l++)
+			block[l] = blake2b_mb_zero;
+
+		for (left = sector_size; left > BLAKE2B_BLOCKBYTES;
+		     left -= BLAKE2B_BLOCKBYTES) {
+			for (l = 0; l < count_l; l++)
+				M.t[l] += BLAKE2B_BLOCKBYTES;
+			blake2b_mb_compress(&M, block, BIT(count_l) - 1);
+			for (l = 0; l < count_l; l++)
+				block[l] += BLAKE2B_BLOCKBYTES;
+			blake2b_mb_yield(&nr);
+		}
+
+		/* Last block, only a partial one is padded */
+		for (l = 0; l < count_l; l++) {
+			if (left < BLAKE2B_BLOCKBYTES) {
+				memcpy(tail[l], block[l], left);
+				memset(tail[l] + left, 0,
+				       BLAKE2B_BLOCKBYTES - left);
+				block[l] = tail[l];
+			}
+			M.t[l] += left;
+			M.f[l] = (u64)-1;
+		}
+		blake2b_mb_compress(&M, block, BIT(count_l) - 1);
+		blake2b_mb_yield(&nr);
+
+		for (l = 0; l < count_l; l++) {
+			blake2b_mb_output(&M, l, digest, outlen);
+			errors += blake2b_sector_out(digest, first + l, out,
+						     sums, mismatch, outlen);
+		}
+	}
+	kernel_fpu_end();
+
+	memzero_explicit(tail, sizeof(tail));
+	memzero_explicit(digest, sizeof(digest));
+	memzero_explicit(h, sizeof(h));
+	memzero_explicit(&M, sizeof(M));
+	return errors;
+}
+
+static int blake2b_sectors(const void *base, size_t sector_size,
+			   unsigned int count, const u8 *key, size_t keylen,
+			   u8 *out, const u8 *sums, unsigned long *mismatch,
+			   unsigned int *nr_mismatch, size_t outlen)
+{
+	u8 digest[BLAKE2B_OUTBYTES];
+	struct blake2b_state init;
+	struct blake2b_state S;
+	const u8 *in = base;
+	unsigned int errors = 0;
+	unsigned int i;
+
+	if (!outlen || outlen > BLAKE2B_OUTBYTES || !sector_size)
+		return -EINVAL;
+	if (keylen > BLAKE2B_KEYBYTES || (keylen && !key))
+		return -EINVAL;
+
+	if (mismatch)
+		bitmap_zero(mismatch, count);
+	if (keylen)
+		blake2b_init_key(&init, outlen, key, keylen);
+	else
+		blake2b_init(&init, outlen);
+
+	if (blake2b_mb_compress && irq_fpu_usable()) {
+		errors = blake2b_mb_sectors(&init, in, sector_size, count,
+					    out, sums, mismatch, outlen);
+	} else {
+		for (i = 0; i < count; i++) {
+			S = init;
+			blake2b_update(&S, in + (size_t)i * sector_size,
+				       sector_size);
+			blake2b_final(&S, digest, outlen);
+			errors += blake2b_sector_out(digest, i, out, sums,
+						     mismatch, outlen);
+		}
+		memzero_explicit(&S, sizeof(S));
+		memzero_explicit(digest, sizeof(digest));
+	}
+	memzero_explicit(&init, sizeof(init));
+	if (nr_mismatch)
+		*nr_mismatch = errors;
+	return 0;
+}
+
+/**
+ * blake2b_digest_sectors - BLAKE2b checksum of each sector of a buffer
+ * @base: count sectors of sector_size bytes each
+ * @sector_size: bytes per sector
+ * @count: number of sectors
+ * @key: the key of every sector, NULL if unkeyed
+ * @keylen: length of the key, 0 to BLAKE2B_KEYBYTES
+ * @out: count digests of outlen bytes, in the order of the sectors
+ * @outlen: digest length, 1 to BLAKE2B_OUTBYTES
+ *
+ * Equivalent to a blake2b() of each sector. With a multi-buffer kernel and a
+ * usable FPU the sectors are hashed side by side on its lanes and the key
+ * block is compressed once for the whole batch.
+ */
+int blake2b_digest_sectors(const void *base, size_t sector_size,
+			   unsigned int count, const u8 *key, size_t keylen,
+			   u8 *out, size_t outlen)
+{
+	return blake2b_sectors(base, sector_size, count, key, keylen, out,
+			       NULL, NULL, NULL, outlen);
+}
+EXPORT_SYMBOL_GPL(blake2b_digest_sectors);
+
+/**
+ * blake2b_verify_sectors - check each sector of a buffer against its checksum
+ * @base: count sectors of sector_size bytes each
+ * @sector_size: bytes per sector
+ * @count: number of sectors
+ * @key: the key of every sector, NULL if unkeyed
+ * @keylen: length of the key, 0 to BLAKE2B_KEYBYTES
+ * @sums: count stored digests of outlen bytes
+ * @outlen: digest length, 1 to BLAKE2B_OUTBYTES
+ * @mismatch: bitmap of count bits, bit i is set when sector i does not match
+ * @nr_mismatch: the number of bits set in @mismatch, may be NULL
+ *
+ * Returns 0, or -EINVAL for a bad digest or key length.
+ */
+int blake2b_verify_sectors(const void *base, size_t sector_size,
+			   unsigned int count, const u8 *key, size_t keylen,
+			   const u8 *sums, size_t outlen,
+			   unsigned long *mismatch, unsigned int *nr_mismatch)
+{
+	return blake2b_sectors(base, sector_size, count, key, keylen, NULL,
+			       sums, mismatch, nr_mismatch, outlen);
+}
+EXPORT_SYMBOL_GPL(blake2b_verify_sectors);
+
+/*
+ * Advance states S[first..first+count) over nblocks blocks of in, their
+ * buffers are either empty or a full block to compress first
+ */
+static void blake2b_mb_update_lanes(struct blake2b_state *const S[],
+				    unsigned int count, const u8 *in,
+				    size_t nblocks)
+{
+	const u8 *block[BLAKE2B_MB_LANES];
+	struct blake2b_mb_state M;
+	u32 mask = BIT(count) - 1;
+	u32 full = 0;
+	size_t chunk;
+	unsigned int l;
+	int i;
+
+	/* The kernel loads the lanes that are masked off too */
+	memset(&M, 0, sizeof(M));
+	for (l = 0; l < blake2b_mb_lanes; l++) {
+		block[l] = blake2b_mb_zero;
+		if (l >= count)
+			continue;
+		for (i = 0; i < 8; i++)
+			M.h[i][l] = S[l]->h[i];
+		M.t[l] = S[l]->t[0];
+		M.f[l] = 0;
+		if (S[l]->buflen) {
+			block[l] = S[l]->buf;
+			M.t[l] += BLAKE2B_BLOCKBYTES;
+			full |= BIT(l);
+		}
+	}
+
+	kernel_fpu_begin();
+	if (full)
+		blake2b_mb_compress(&M, block, full);
+	while (nblocks) {
+		chunk = min_t(size_t, nblocks, BLAKE2B_MB_FPU_BLOCKS);
+		blake2b_mb_bcast(&M, in, chunk, mask);
+		in += chunk * BLAKE2B_BLOCKBYTES;
+		nblocks -= chunk;
+		if (nblocks) {
+			kernel_fpu_end();
+			kernel_fpu_begin();
+		}
+	}
+	kernel_fpu_end();
+
+	for (l = 0; l < count; l++) {
+		for (i = 0; i < 8; i++)
+			S[l]->h[i] = M.h[i][l];
+		S[l]->t[0] = M.t[l];
+	}
+	memzero_explicit(&M, sizeof(M));
+}
+
+/**
+ * blake2b_update_many - feed the same data to several BLAKE2b states
+ * @S: the states, each with its own key, parameter block or digest length
+ * @n: number of states
+ * @in: the data
+ * @inlen: length of the data
+ *
+ * Equivalent to blake2b_update() of each state. States at the same offset
+ * within a block advance in lockstep on the lanes of the multi-buffer kernel
+ * with every message block loaded once for all of them, states that do not
+ * fit that are updated one by one. Finish each state with blake2b_final().
+ */
+int blake2b_update_many(struct blake2b_state *const S[], unsigned int n,
+			const void *in, size_t inlen)
+{
+	const u8 *data = in;
+	size_t fill, nblocks;
+	unsigned int i;
+
+	if (!n || !inlen)
+		return 0;
+
+	if (!blake2b_mb_bcast || !irq_fpu_usable())
+		goto serial;
+	for (i = 0; i < n; i++) {
+		if (S[i]->buflen % BLAKE2B_BLOCKBYTES !=
+		    S[0]->buflen % BLAKE2B_BLOCKBYTES || S[i]->t[1] ||
+		    S[i]->f[0])
+			goto serial;
+	}
+
+	/* Complete the partial buffers, at least one byte must follow */
+	fill = (BLAKE2B_BLOCKBYTES - S[0]->buflen) % BLAKE2B_BLOCKBYTES;
+	if (inlen <= fill)
+		goto serial;
+	for (i = 0; i < n; i++) {
+		if (!fill)
+			continue;
+		memcpy(S[i]->buf + S[i]->buflen, data, fill);
+		S[i]->buflen = BLAKE2B_BLOCKBYTES;
+	}
+	data += fill;
+	inlen -= fill;
+
+	/* All but the last block, it may be the final one */
+	nblocks = DIV_ROUND_UP(inlen, BLAKE2B_BLOCKBYTES) - 1;
+	for (i = 0; i < n; i += blake2b_mb_lanes)
+		blake2b_mb_update_lanes(S + i, min(n - i, blake2b_mb_lanes),
+					data, nblocks);
+	data += nblocks * BLAKE2B_BLOCKBYTES;
+	inlen -= nblocks * BLAKE2B_BLOCKBYTES;
+
+	for (i = 0; i < n; i++) {
+		memcpy(S[i]->buf, data, inlen);
+		S[i]->buflen = inlen;
+	}
+	return 0;
+
+serial:
+	for (i = 0; i < n; i++)
+		blake2b_update(S[i], data, inlen);
+	return 0;
+}
+EXPORT_SYMBOL_GPL(blake2b_update_many);
+
+/*
+ * BLAKE2bp leaves, S[l] gets block l of each of the nstripes stripes of in.
+ * Like blake2b_update() of each leaf the last block stays buffered, the
+ * buffers are either empty or a full block to compress first.
+ */
+void blake2b_mb_update_stripes(struct blake2b_state *S, unsigned int count,
+			       const u8 *in, size_t nstripes)
+{
+	const u8 *block[BLAKE2B_MB_LANES];
+	struct blake2b_mb_state M;
+	u32 mask = BIT(count) - 1;
+	u32 full = 0;
+	size_t k;
+	unsigned int l;
+	int i;
+
+	/* The kernel loads the lanes that are masked off too */
+	memset(&M, 0, sizeof(M));
+	for (l = 0; l < blake2b_mb_lanes; l++) {
+		block[l] = blake2b_mb_zero;
+		if (l >= count)
+			continue;
+		for (i = 0; i < 8; i++)
+			M.h[i][l] = S[l].h[i];
+		M.t[l] = S[l].t[0];
+		M.f[l] = 0;
+		if (S[l].buflen) {
+			block[l] = S[l].buf;
+			M.t[l] += BLAKE2B_BLOCKBYTES;
+			full |= BIT(l);
+		}
+	}
+
+	kernel_fpu_begin();
+	if (full)
+		blake2b_mb_compress(&M, block, full);
+	for (k = 1; k < nstripes; k++) {
+		for (l = 0; l < count; l++) {
+			block[l] = in + l * BLAKE2B_BLOCKBYTES;
+			M.t[l] += BLAKE2B_BLOCKBYTES;
+		}
+		blake2b_mb_compress(&M, block, mask);
+		in += count * BLAKE2B_BLOCKBYTES;
+		if (k % BLAKE2B_MB_FPU_BLOCKS == 0) {
+			kernel_fpu_end();
+			kernel_fpu_begin();
+		}
+	}
+	kernel_fpu_end();
+
+	for (l = 0; l < count; l++) {
+		for (i = 0; i < 8; i++)
+			S[l].h[i] = M.h[i][l];
+		S[l].t[0] = M.t[l];
+		memcpy(S[l].buf, in + l * BLAKE2B_BLOCKBYTES,
+		       BLAKE2B_BLOCKBYTES);
+		S[l].buflen = BLAKE2B_BLOCKBYTES;
+	}
+	memzero_explicit(&M, sizeof(M));
+}
+
+/*
+ * BLAKE2Xb output blocks, each lane compresses the root from C with its own
+ * node offset, first + l. C is the output node state at node offset 0.
+ */
+void blake2b_mb_xof_blocks(const struct blake2b_state *C, const u8 *root,
+			   u32 first, size_t nblocks, u8 *out)
+{
+	const u8 *block[BLAKE2B_MB_LANES];
+	u8 pad[BLAKE2B_BLOCKBYTES];
+	struct blake2b_mb_state M;
+	unsigned int count;
+	unsigned int nr = 0;
+	unsigned int l;
+	int i;
+
+	memcpy(pad, root, BLAKE2B_OUTBYTES);
+	memset(pad + BLAKE2B_OUTBYTES, 0, BLAKE2B_BLOCKBYTES - BLAKE2B_OUTBYTES);
+	for (l = 0; l < blake2b_mb_lanes; l++)
+		block[l] = pad;
+	/* The kernel loads the lanes that are masked off too */
+	memset(&M, 0, sizeof(M));
+
+	kernel_fpu_begin();
+	while (nblocks) {
+		count = min_t(size_t, nblocks, blake2b_mb_lanes);
+		for (l = 0; l < count; l++) {
+			for (i = 0; i < 8; i++)
+				M.h[i][l] = C->h[i];
+			/* The node offset is the low half of parameter word 1 */
+			M.h[1][l] ^= first + l;
+			M.t[l] = BLAKE2B_OUTBYTES;
+			M.f[l] = (u64)-1;
+		}
+		blake2b_mb_compress(&M, block, BIT(count) - 1);
+		for (l = 0; l < count; l++)
+			blake2b_mb_output(&M, l, out + l * BLAKE2B_OUTBYTES,
+					  BLAKE2B_OUTBYTES);
+
+		first += count;
+		out += count * BLAKE2B_OUTBYTES;
+		nblocks -= count;
+		if (++nr == BLAKE2B_MB_FPU_BLOCKS && nblocks) {
+			kernel_fpu_end();
+			kernel_fpu_begin();
+			nr = 0;
+		}
+	}
+	kernel_fpu_end();
+
+	memzero_explicit(pad, sizeof(pad));
+	memzero_explicit(&M, sizeof(M));
+}
+
+/* Lanes of the multi-buffer kernel, 0 if there is none */
+unsigned int blake2b_mb_nr_lanes(void)
+{
+	return blake2b_mb_lanes;
+}
+
+/* The 8-way kernel runs on zmm, skip it where that costs frequency */
+void __init blake2b_mb_init(void)
+{
+	if (boot_cpu_has(X86_FEATURE_AVX512F) &&
+	    !boot_cpu_has(X86_FEATURE_PREFER_YMM) &&
+	    cpu_has_xfeatures(XFEATURE_MASK_SSE | XFEATURE_MASK_YMM |
+			      XFEATURE_MASK_AVX512, NULL)) {
+		blake2b_mb_compress = blake2b_compress_mb8_avx512;
+		blake2b_mb_bcast = blake2b_compress_mb8_bcast_avx512;
+		blake2b_mb_lanes = 8;
+	} else if (boot_cpu_has(X86_FEATURE_AVX) &&
+		   boot_cpu_has(X86_FEATURE_AVX2) &&
+		   cpu_has_xfeatures(XFEATURE_MASK_SSE | XFEATURE_MASK_YMM,
+				     NULL)) {
+		blake2b_mb_compress = blake2b_compress_mb4_avx2;
+		blake2b_mb_bcast = blake2b_compress_mb4_bcast_avx2;
+		blake2b_mb_lanes = 4;
+	}
+}
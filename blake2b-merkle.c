@@ -0,0 +1,266 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * Incremental BLAKE2b Merkle tree, included by blake2b-glue.c
+ *
+ * A binary tree over leaves of leaf_size bytes. Every node digest is kept in
+ * one array, level by level from the leaves up to the root, so rewriting a
+ * range of leaves rehashes those leaves and their paths to the root only.
+ * Each node is hashed with its node offset and depth in the parameter block,
+ * the last node of each level is flagged as such.
+ */
+
+#include <crypto/algapi.h>
+#include <linux/err.h>
+#include <linux/overflow.h>
+
+#define BLAKE2B_MERKLE_MAGIC	0x6b4d3262	/* "b2Mk" */
+
+/*
+ * Up to 2^31 leaves so the node count, 2^32 - 1 at most, fits a u32. The
+ * leaves are halved until one node is left.
+ */
+#define BLAKE2B_MERKLE_MAX_LEAVES	(1ULL << 31)
+#define BLAKE2B_MERKLE_MAX_LEVELS	32
+
+struct blake2b_merkle {
+	u64 size;
+	u32 leaf_size;
+	u32 levels;
+	u32 nnodes;
+	u32 level_start[BLAKE2B_MERKLE_MAX_LEVELS];
+	u32 level_nodes[BLAKE2B_MERKLE_MAX_LEVELS];
+	u8 node[][BLAKE2B_OUTBYTES];
+};
+
+/* Serialized node cache, followed by the nodes in array order */
+struct blake2b_merkle_header {
+	__le32 magic;
+	__le32 leaf_size;
+	__le64 size;
+};
+
+static int blake2b_merkle_layout(struct blake2b_merkle *M, u64 size,
+				 u32 leaf_size)
+{
+	u64 nleaves, start = 0;
+	u32 n;
+
+	if (!leaf_size)
+		return -EINVAL;
+	nleaves = max_t(u64, DIV_ROUND_UP_ULL(size, leaf_size), 1);
+	if (nleaves > BLAKE2B_MERKLE_MAX_LEAVES)
+		return -EINVAL;
+
+	M->size = size;
+	M->leaf_size = leaf_size;
+	M->levels = 0;
+	n = nleaves;
+	for (;;) {
+		M->level_start[M->levels] = start;
+		M->level_nodes[M->levels] = n;
+		M->levels++;
+		start += n;
+		if (n == 1)
+			break;
+		n = DIV_ROUND_UP(n, 2);
+	}
+	if (start > U32_MAX)
+		return -EINVAL;
+	M->nnodes = start;
+	return 0;
+}
+
+static void blake2b_merkle_hash(struct blake2b_merkle *M, u32 level,
+				u32 offset, const void *in, size_t inlen)
+{
+	struct blake2b_param P[1];
+	struct blake2b_state S;
+
+	P->digest_length = BLAKE2B_OUTBYTES;
+	P->key_length    = 0;
+	P->fanout        = 2;
+	P->depth         = (u8)M->levels;
+	store32(&P->leaf_length, M->leaf_size);
+	store32(&P->node_offset, offset);
+	store32(&P->xof_length, 0);
+	P->node_depth    = (u8)level;
+	P->inner_length  = BLAKE2B_OUTBYTES;
+	memset(P->reserved, 0, sizeof(P->reserved));
+	memset(P->salt,     0, sizeof(P->salt));
+	memset(P->personal, 0, sizeof(P->personal));
+	blake2b_init_param(&S, P);
+	if (offset == M->level_nodes[level] - 1)
+		S.last_node = 1;
+
+	blake2b_finup_arch(&S, in, inlen,
+			   M->node[M->level_start[level] + offset]);
+}
+
+/* Interior nodes over the changed leaves first to last, up to the root */
+static void blake2b_merkle_rehash(struct blake2b_merkle *M, u32 first,
+				  u32 last)
+{
+	u32 level, j;
+
+	for (level = 1; level < M->levels; level++) {
+		const u32 below = M->level_start[level - 1];
+
+		first /= 2;
+		last /= 2;
+		for (j = first; j <= last; j++) {
+			u32 children = min(M->level_nodes[level - 1] - 2 * j, 2U);
+
+			blake2b_merkle_hash(M, level, j, M->node[below + 2 * j],
+					    children * BLAKE2B_OUTBYTES);
+		}
+	}
+}
+
+/**
+ * blake2b_merkle_alloc - Merkle tree of an object
+ * @size: object size in bytes
+ * @leaf_size: bytes per leaf
+ * @gfp: allocation flags
+ *
+ * The nodes start zeroed, the root is valid once every leaf has been written
+ * by blake2b_merkle_update(). Returns an ERR_PTR() on failure.
+ */
+struct blake2b_merkle *blake2b_merkle_alloc(u64 size, u32 leaf_size,
+					    gfp_t gfp)
+{
+	struct blake2b_merkle layout;
+	struct blake2b_merkle *M;
+	int ret;
+
+	ret = blake2b_merkle_layout(&layout, size, leaf_size);
+	if (ret)
+		return ERR_PTR(ret);
+
+	M = kvzalloc(struct_size(M, node, layout.nnodes), gfp);
+	if (!M)
+		return ERR_PTR(-ENOMEM);
+	*M = layout;
+	return M;
+}
+EXPORT_SYMBOL_GPL(blake2b_merkle_alloc);
+
+void blake2b_merkle_free(struct blake2b_merkle *M)
+{
+	kvfree(M);
+}
+EXPORT_SYMBOL_GPL(blake2b_merkle_free);
+
+/**
+ * blake2b_merkle_update - new contents of a range of leaves
+ * @M: the tree
+ * @offset: object offset, a multiple of the leaf size
+ * @data: the new contents
+ * @len: a multiple of the leaf size, or up to the end of the object
+ *
+ * Hashes the leaves covered by the range and the nodes above them.
+ */
+int blake2b_merkle_update(struct blake2b_merkle *M, u64 offset,
+			  const void *data, size_t len)
+{
+	const u8 *in = data;
+	u32 first, last, i;
+
+	if (offset > M->size || len > M->size - offset)
+		return -EINVAL;
+	if (offset % M->leaf_size)
+		return -EINVAL;
+	if (len % M->leaf_size && offset + len != M->size)
+		return -EINVAL;
+	/* Only the empty object has an empty leaf */
+	if (!len && M->size)
+		return 0;
+
+	first = offset / M->leaf_size;
+	last = len ? first + (u32)DIV_ROUND_UP_ULL(len, M->leaf_size) - 1 :
+		     first;
+	for (i = first; i <= last; i++) {
+		size_t chunk = min_t(size_t, len, M->leaf_size);
+
+		blake2b_merkle_hash(M, 0, i, in, chunk);
+		in += chunk;
+		len -= chunk;
+	}
+
+	blake2b_merkle_rehash(M, first, last);
+	return 0;
+}
+EXPORT_SYMBOL_GPL(blake2b_merkle_update);
+
+/* The root digest, BLAKE2B_OUTBYTES */
+void blake2b_merkle_root(const struct blake2b_merkle *M, u8 *out)
+{
+	memcpy(out, M->node[M->nnodes - 1], BLAKE2B_OUTBYTES);
+}
+EXPORT_SYMBOL_GPL(blake2b_merkle_root);
+
+/* Bytes needed by blake2b_merkle_save() */
+size_t blake2b_merkle_cache_size(const struct blake2b_merkle *M)
+{
+	return sizeof(struct blake2b_merkle_header) +
+	       (size_t)M->nnodes * BLAKE2B_OUTBYTES;
+}
+EXPORT_SYMBOL_GPL(blake2b_merkle_cache_size);
+
+int blake2b_merkle_save(const struct blake2b_merkle *M, void *buf, size_t len)
+{
+	struct blake2b_merkle_header *hdr = buf;
+
+	if (len < blake2b_merkle_cache_size(M))
+		return -EINVAL;
+
+	hdr->magic = cpu_to_le32(BLAKE2B_MERKLE_MAGIC);
+	hdr->leaf_size = cpu_to_le32(M->leaf_size);
+	hdr->size = cpu_to_le64(M->size);
+	memcpy(hdr + 1, M->node, (size_t)M->nnodes * BLAKE2B_OUTBYTES);
+	return 0;
+}
+EXPORT_SYMBOL_GPL(blake2b_merkle_save);
+
+/**
+ * blake2b_merkle_restore - tree from a saved node cache
+ * @buf: output of blake2b_merkle_save()
+ * @len: length of buf
+ * @gfp: allocation flags
+ *
+ * The leaf digests are trusted and the interior nodes are recomputed from
+ * them, a cache that does not match is rejected with -EBADMSG.
+ */
+struct blake2b_merkle *blake2b_merkle_restore(const void *buf, size_t len,
+					      gfp_t gfp)
+{
+	const struct blake2b_merkle_header *hdr = buf;
+	const void *saved = hdr + 1;
+	struct blake2b_merkle layout;
+	struct blake2b_merkle *M;
+	size_t nodes_len;
+
+	if (len < sizeof(*hdr) ||
+	    le32_to_cpu(hdr->magic) != BLAKE2B_MERKLE_MAGIC)
+		return ERR_PTR(-EINVAL);
+
+	/* Check the length before allocating for an untrusted size */
+	if (blake2b_merkle_layout(&layout, le64_to_cpu(hdr->size),
+				  le32_to_cpu(hdr->leaf_size)))
+		return ERR_PTR(-EINVAL);
+	nodes_len = (size_t)layout.nnodes * BLAKE2B_OUTBYTES;
+	if (len != sizeof(*hdr) + nodes_len)
+		return ERR_PTR(-EINVAL);
+
+	M = blake2b_merkle_alloc(layout.size, layout.leaf_size, gfp);
+	if (IS_ERR(M))
+		return M;
+
+	memcpy(M->node, saved, (size_t)M->level_nodes[0] * BLAKE2B_OUTBYTES);
+	blake2b_merkle_rehash(M, 0, M->level_nodes[0] - 1);
+	if (crypto_memneq(M->node, saved, nodes_len)) {
+		blake2b_merkle_free(M);
+		return ERR_PTR(-EBADMSG);
+	}
+	return M;
+}
+EXPORT_SYMBOL_GPL(blake2b_merkle_restore);
@@ -0,0 +1,479 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * Known answer tests run at module init, included by blake2b.c
+ *
+ * The message is in[i] = i mod 256 and the key 00..3f. The vectors up
+ * to 255 bytes are from the reference blake2bp-kat.txt, the longer ones
+ * reach the stripe path and were made with the reference code. Each one is
+ * hashed in one piece and split in two updates, on the generic leaves and
+ * on the _arch ones.
+ *
+ * BLAKE2Xb is checked with a known, an unknown and a long output length, each
+ * through the generic output blocks and the _arch ones.
+ */
+
+#include <linux/bitmap.h>
+#include <linux/slab.h>
+
+#define BLAKE2B_SELFTEST_MAXLEN	2049
+
+static const u16 blake2bp_kat_len[] __initconst = {
+	0, 1, 127, 128, 129, 255, 511, 512, 1023, 2049
+};
+
+static const u8 blake2bp_kat[][BLAKE2B_OUTBYTES] __initconst = {
+	{ 0x9d, 0x94, 0x61, 0x07, 0x3e, 0x4e, 0xb6, 0x40,
+	  0xa2, 0x55, 0x35, 0x7b, 0x83, 0x9f, 0x39, 0x4b,
+	  0x83, 0x8c, 0x6f, 0xf5, 0x7c, 0x9b, 0x68, 0x6a,
+	  0x3f, 0x76, 0x10, 0x7c, 0x10, 0x66, 0x72, 0x8f,
+	  0x3c, 0x99, 0x56, 0xbd, 0x78, 0x5c, 0xbc, 0x3b,
+	  0xf7, 0x9d, 0xc2, 0xab, 0x57, 0x8c, 0x5a, 0x0c,
+	  0x06, 0x3b, 0x9d, 0x9c, 0x40, 0x58, 0x48, 0xde,
+	  0x1d, 0xbe, 0x82, 0x1c, 0xd0, 0x5c, 0x94, 0x0a },
+	{ 0xff, 0x8e, 0x90, 0xa3, 0x7b, 0x94, 0x62, 0x39,
+	  0x32, 0xc5, 0x9f, 0x75, 0x59, 0xf2, 0x60, 0x35,
+	  0x02, 0x9c, 0x37, 0x67, 0x32, 0xcb, 0x14, 0xd4,
+	  0x16, 0x02, 0x00, 0x1c, 0xbb, 0x73, 0xad, 0xb7,
+	  0x92, 0x93, 0xa2, 0xdb, 0xda, 0x5f, 0x60, 0x70,
+	  0x30, 0x25, 0x14, 0x4d, 0x15, 0x8e, 0x27, 0x35,
+	  0x52, 0x95, 0x96, 0x25, 0x1c, 0x73, 0xc0, 0x34,
+	  0x5c, 0xa6, 0xfc, 0xcb, 0x1f, 0xb1, 0xe9, 0x7e },
+	{ 0x79, 0x26, 0x70, 0x88, 0x59, 0xe6, 0xe2, 0xab,
+	  0x68, 0xf6, 0x04, 0xda, 0x69, 0xa9, 0xfb, 0x50,
+	  0x87, 0xbb, 0x33, 0xf4, 0xe8, 0xd8, 0x95, 0x73,
+	  0x0e, 0x30, 0x1a, 0xb2, 0xd7, 0xdf, 0x74, 0x8b,
+	  0x67, 0xdf, 0x0b, 0x6b, 0x86, 0x22, 0xe5, 0x2d,
+	  0xd5, 0x7d, 0x8d, 0x3a, 0xd8, 0x7d, 0x58, 0x20,
+	  0xd4, 0xec, 0xfd, 0x24, 0x17, 0x8b, 0x2d, 0x2b,
+	  0x78, 0xd6, 0x4f, 0x4f, 0xbd, 0x38, 0x75, 0x82 },
+	{ 0x92, 0x80, 0xf4, 0xd1, 0x15, 0x70, 0x32, 0xab,
+	  0x31, 0x5c, 0x10, 0x0d, 0x63, 0x62, 0x83, 0xfb,
+	  0xf4, 0xfb, 0xa2, 0xfb, 0xad, 0x0f, 0x8b, 0xc0,
+	  0x20, 0x72, 0x1d, 0x76, 0xbc, 0x1c, 0x89, 0x73,
+	  0xce, 0xd2, 0x88, 0x71, 0xcc, 0x90, 0x7d, 0xab,
+	  0x60, 0xe5, 0x97, 0x56, 0x98, 0x7b, 0x0e, 0x0f,
+	  0x86, 0x7f, 0xa2, 0xfe, 0x9d, 0x90, 0x41, 0xf2,
+	  0xc9, 0x61, 0x80, 0x74, 0xe4, 0x4f, 0xe5, 0xe9 },
+	{ 0x55, 0x30, 0xc2, 0xd5, 0x9f, 0x14, 0x48, 0x72,
+	  0xe9, 0x87, 0xe4, 0xe2, 0x58, 0xa7, 0xd8, 0xc3,
+	  0x8c, 0xe8, 0x44, 0xe2, 0xcc, 0x2e, 0xed, 0x94,
+	  0x0f, 0xfc, 0x68, 0x3b, 0x49, 0x88, 0x15, 0xe5,
+	  0x3a, 0xdb, 0x1f, 0xaa, 0xf5, 0x68, 0x94, 0x61,
+	  0x22, 0x80, 0x5a, 0xc3, 0xb8, 0xe2, 0xfe, 0xd4,
+	  0x35, 0xfe, 0xd6, 0x16, 0x2e, 0x76, 0xf5, 0x64,
+	  0xe5, 0x86, 0xba, 0x46, 0x44, 0x24, 0xe8, 0x85 },
+	{ 0x96, 0xfb, 0xcb, 0xb6, 0x0b, 0xd3, 0x13, 0xb8,
+	  0x84, 0x50, 0x33, 0xe5, 0xbc, 0x05, 0x8a, 0x38,
+	  0x02, 0x74, 0x38, 0x57, 0x2d, 0x7e, 0x79, 0x57,
+	  0xf3, 0x68, 0x4f, 0x62, 0x68, 0xaa, 0xdd, 0x3a,
+	  0xd0, 0x8d, 0x21, 0x76, 0x7e, 0xd6, 0x87, 0x86,
+	  0x85, 0x33, 0x1b, 0xa9, 0x85, 0x71, 0x48, 0x7e,
+	  0x12, 0x47, 0x0a, 0xad, 0x66, 0x93, 0x26, 0x71,
+	  0x6e, 0x46, 0x66, 0x7f, 0x69, 0xf8, 0xd7, 0xe8 },
+	{ 0xeb, 0x7b, 0x7b, 0xb4, 0xd5, 0x21, 0x70, 0x25,
+	  0x70, 0x5e, 0x94, 0x9d, 0x98, 0xdb, 0x93, 0xee,
+	  0x62, 0xe6, 0x4f, 0x6f, 0xb9, 0xe6, 0xf4, 0x51,
+	  0x08, 0xa5, 0xf7, 0xeb, 0xe2, 0x90, 0x81, 0x61,
+	  0x29, 0x4b, 0x0e, 0x8c, 0x90, 0x4a, 0xfa, 0x9d,
+	  0x57, 0xc5, 0x06, 0xe9, 0xda, 0x3b, 0x02, 0x80,
+	  0x6f, 0xd5, 0x76, 0x7a, 0xe5, 0x54, 0x98, 0xeb,
+	  0x3b, 0xb8, 0xcd, 0x7f, 0x09, 0x1b, 0x57, 0x2d },
+	{ 0x14, 0xba, 0x32, 0xc1, 0xc8, 0x0b, 0xb3, 0x2c,
+	  0x82, 0x82, 0xaa, 0x53, 0xf3, 0x41, 0xf4, 0x5d,
+	  0xaa, 0xbd, 0xa1, 0x2b, 0xda, 0x41, 0xf7, 0xad,
+	  0x8e, 0xc7, 0x5b, 0xaa, 0x74, 0x3a, 0x41, 0xad,
+	  0xf2, 0x37, 0x6a, 0xd3, 0xde, 0x32, 0xfb, 0x57,
+	  0x6d, 0x3e, 0xfd, 0xca, 0xdf, 0x3f, 0x59, 0xd2,
+	  0x5b, 0x40, 0xb9, 0x15, 0x68, 0x1c, 0xc9, 0x0d,
+	  0xee, 0x3a, 0x9b, 0x2c, 0xb0, 0x20, 0x61, 0xea },
+	{ 0xf8, 0x90, 0x25, 0x62, 0x40, 0x0a, 0xf0, 0xa1,
+	  0x68, 0x74, 0xe0, 0xab, 0x43, 0x2d, 0x54, 0x42,
+	  0xdf, 0xa8, 0x24, 0x39, 0xa2, 0x20, 0xf9, 0x27,
+	  0xc8, 0xc6, 0x54, 0x07, 0x6c, 0xdb, 0x1f, 0xd8,
+	  0x4b, 0x6f, 0x60, 0xa1, 0x70, 0xda, 0x9e, 0x81,
+	  0xe4, 0xeb, 0x03, 0xa0, 0xe8, 0x2a, 0x66, 0xed,
+	  0xc3, 0x9a, 0x3f, 0xca, 0xff, 0x3b, 0x8c, 0xbb,
+	  0x53, 0x8e, 0x87, 0x73, 0x89, 0x50, 0x24, 0x65 },
+	{ 0x8f, 0x9d, 0x23, 0xfe, 0x78, 0xaf, 0x91, 0xf8,
+	  0xd6, 0xa7, 0xae, 0xc6, 0x05, 0xc3, 0x09, 0x0a,
+	  0xa9, 0xb0, 0x96, 0xa0, 0x70, 0x8d, 0xbb, 0x63,
+	  0xc6, 0xb5, 0x9f, 0x2e, 0x49, 0xde, 0x12, 0x1b,
+	  0x53, 0x06, 0x41, 0x78, 0xd1, 0xd3, 0x22, 0xf2,
+	  0x3f, 0xef, 0x93, 0xf3, 0x1f, 0xbc, 0xa9, 0xd4,
+	  0x6e, 0x2d, 0x31, 0xf9, 0xdc, 0x6d, 0x41, 0x6f,
+	  0x2c, 0xf3, 0xde, 0x6a, 0x85, 0x96, 0xf1, 0x96 },
+};
+
+#define BLAKE2XB_SELFTEST_INLEN		256
+#define BLAKE2XB_SELFTEST_UNKNOWN	200
+#define BLAKE2XB_SELFTEST_LONG		(17 * BLAKE2B_OUTBYTES + 17)
+
+/* Keyed BLAKE2Xb of the first 256 bytes, from the reference blake2xb-kat.txt */
+static const u16 blake2xb_kat_len[] __initconst = {
+	1, 64, 65, 129, 256
+};
+
+static const u8 blake2xb_kat[] __initconst = {
+	0x64,
+	0x43, 0x24, 0x56, 0x1d, 0x76, 0xc3, 0x70, 0xef,
+	0x35, 0xac, 0x36, 0xa4, 0xad, 0xf8, 0xf3, 0x77,
+	0x3a, 0x50, 0xd8, 0x65, 0x04, 0xbd, 0x28, 0x4f,
+	0x71, 0xf7, 0xce, 0x9e, 0x2b, 0xc4, 0xc1, 0xf1,
+	0xd3, 0x4a, 0x7f, 0xb2, 0xd6, 0x75, 0x61, 0xd1,
+	0x01, 0x95, 0x5d, 0x44, 0x8b, 0x67, 0x57, 0x7e,
+	0xb3, 0x0d, 0xfe, 0xe9, 0x6a, 0x95, 0xc7, 0xf9,
+	0x21, 0xef, 0x53, 0xe2, 0x0b, 0xe8, 0xbc, 0x44,
+	0x78, 0xf0, 0xed, 0x6e, 0x22, 0x0b, 0x3d, 0xa3,
+	0xcc, 0x93, 0x81, 0x56, 0x3b, 0x2f, 0x72, 0xc8,
+	0xdc, 0x83, 0x0c, 0xb0, 0xf3, 0x9a, 0x48, 0xc6,
+	0xae, 0x47, 0x9a, 0x6a, 0x78, 0xdc, 0xfa, 0x94,
+	0x00, 0x26, 0x31, 0xde, 0xc4, 0x67, 0xe9, 0xe9,
+	0xb4, 0x7c, 0xc8, 0xf0, 0x88, 0x7e, 0xb6, 0x80,
+	0xe3, 0x40, 0xae, 0xc3, 0xec, 0x00, 0x9d, 0x4a,
+	0x33, 0xd2, 0x41, 0x53, 0x3c, 0x76, 0xc8, 0xca,
+	0x8c,
+	0x77, 0xdf, 0xf4, 0xc7, 0xad, 0x30, 0xc9, 0x54,
+	0x33, 0x8c, 0x4b, 0x23, 0x63, 0x9d, 0xae, 0x4b,
+	0x27, 0x50, 0x86, 0xcb, 0xe6, 0x54, 0xd4, 0x01,
+	0xa2, 0x34, 0x35, 0x28, 0x06, 0x5e, 0x4c, 0x9f,
+	0x1f, 0x2e, 0xca, 0x22, 0xaa, 0x02, 0x5d, 0x49,
+	0xca, 0x82, 0x3e, 0x76, 0xfd, 0xbb, 0x35, 0xdf,
+	0x78, 0xb1, 0xe5, 0x07, 0x5f, 0xf2, 0xc8, 0x2b,
+	0x68, 0x0b, 0xca, 0x38, 0x5c, 0x6d, 0x57, 0xf7,
+	0xea, 0x7d, 0x10, 0x30, 0xbb, 0x39, 0x25, 0x27,
+	0xb2, 0x5d, 0xd7, 0x3e, 0x9e, 0xef, 0xf9, 0x7b,
+	0xea, 0x39, 0x7c, 0xf3, 0xb9, 0xdd, 0xa0, 0xc8,
+	0x17, 0xa9, 0xc8, 0x70, 0xed, 0x12, 0xc0, 0x06,
+	0xcc, 0x05, 0x49, 0x68, 0xc6, 0x40, 0x00, 0xe0,
+	0xda, 0x87, 0x4e, 0x9b, 0x7d, 0x7d, 0x62, 0x1b,
+	0x06, 0x79, 0x86, 0x69, 0x12, 0x24, 0x3e, 0xa0,
+	0x96, 0xc7, 0xb3, 0x8a, 0x13, 0x44, 0xe9, 0x8f,
+	0x74,
+	0x1e, 0x9b, 0x2c, 0x45, 0x4e, 0x9d, 0xe3, 0xa2,
+	0xd7, 0x23, 0xd8, 0x50, 0x33, 0x10, 0x37, 0xdb,
+	0xf5, 0x41, 0x33, 0xdb, 0xe2, 0x74, 0x88, 0xff,
+	0x75, 0x7d, 0xd2, 0x55, 0x83, 0x3a, 0x27, 0xd8,
+	0xeb, 0x8a, 0x12, 0x8a, 0xd1, 0x2d, 0x09, 0x78,
+	0xb6, 0x88, 0x4e, 0x25, 0x73, 0x70, 0x86, 0xa7,
+	0x04, 0xfb, 0x28, 0x9a, 0xaa, 0xcc, 0xf9, 0x30,
+	0xd5, 0xb5, 0x82, 0xab, 0x4d, 0xf1, 0xf5, 0x5f,
+	0x0c, 0x42, 0x9b, 0x68, 0x75, 0xed, 0xec, 0x3f,
+	0xe4, 0x54, 0x64, 0xfa, 0x74, 0x16, 0x4b, 0xe0,
+	0x56, 0xa5, 0x5e, 0x24, 0x3c, 0x42, 0x22, 0xc5,
+	0x86, 0xbe, 0xc5, 0xb1, 0x8f, 0x39, 0x03, 0x6a,
+	0xa9, 0x03, 0xd9, 0x81, 0x80, 0xf2, 0x4f, 0x83,
+	0xd0, 0x9a, 0x45, 0x4d, 0xfa, 0x1e, 0x03, 0xa6,
+	0x0e, 0x6a, 0x3b, 0xa4, 0x61, 0x3e, 0x99, 0xc3,
+	0x5f, 0x87, 0x4d, 0x79, 0x01, 0x74, 0xee, 0x48,
+	0xa5, 0x57, 0xf4, 0xf0, 0x21, 0xad, 0xe4, 0xd1,
+	0xb2, 0x78, 0xd7, 0x99, 0x7e, 0xf0, 0x94, 0x56,
+	0x9b, 0x37, 0xb3, 0xdb, 0x05, 0x05, 0x95, 0x1e,
+	0x9e, 0xe8, 0x40, 0x0a, 0xda, 0xea, 0x27, 0x5c,
+	0x6d, 0xb5, 0x1b, 0x32, 0x5e, 0xe7, 0x30, 0xc6,
+	0x9d, 0xf9, 0x77, 0x45, 0xb5, 0x56, 0xae, 0x41,
+	0xcd, 0x98, 0x74, 0x1e, 0x28, 0xaa, 0x3a, 0x49,
+	0x54, 0x45, 0x41, 0xee, 0xb3, 0xda, 0x1b, 0x1e,
+	0x8f, 0xa4, 0xe8, 0xe9, 0x10, 0x0d, 0x66, 0xdd,
+	0x0c, 0x7f, 0x5e, 0x2c, 0x27, 0x1b, 0x1e, 0xcc,
+	0x07, 0x7d, 0xe7, 0x9c, 0x46, 0x2b, 0x9f, 0xe4,
+	0xc2, 0x73, 0x54, 0x3e, 0xcd, 0x82, 0xa5, 0xbe,
+	0xa6, 0x3c, 0x5a, 0xcc, 0x01, 0xec, 0xa5, 0xfb,
+	0x78, 0x0c, 0x7d, 0x7c, 0x8c, 0x9f, 0xe2, 0x08,
+	0xae, 0x8b, 0xd5, 0x0c, 0xad, 0x17, 0x69, 0x69,
+	0x3d, 0x92, 0xc6, 0xc8, 0x64, 0x9d, 0x20, 0xd8,
+};
+
+/* The same with an unknown output length, made with the reference code */
+static const u8 blake2xb_kat_unknown[BLAKE2XB_SELFTEST_UNKNOWN] __initconst = {
+	0x3d, 0xbb, 0xa8, 0x51, 0x6d, 0xa7, 0x6b, 0xf7,
+	0x33, 0x00, 0x55, 0xc6, 0x6e, 0xa3, 0x6c, 0xf1,
+	0x00, 0x5e, 0x92, 0x71, 0x42, 0x62, 0xb2, 0x4d,
+	0x97, 0x10, 0xf5, 0x1d, 0x9e, 0x12, 0x64, 0x06,
+	0xe1, 0xbc, 0xd6, 0x49, 0x70, 0x59, 0xf9, 0x33,
+	0x1f, 0x10, 0x91, 0xc3, 0x63, 0x4b, 0x69, 0x54,
+	0x28, 0xd4, 0x75, 0xed, 0x43, 0x2f, 0x98, 0x70,
+	0x40, 0x57, 0x55, 0x20, 0xa1, 0xc2, 0x9f, 0x5e,
+	0x6e, 0xe7, 0x18, 0x9d, 0x60, 0x1a, 0x40, 0x9f,
+	0x99, 0x6b, 0xa0, 0x4b, 0x54, 0x14, 0xb1, 0xb0,
+	0x4b, 0x28, 0xf2, 0x21, 0x4d, 0x3c, 0xc6, 0xad,
+	0xe5, 0x90, 0x74, 0xb6, 0x16, 0x11, 0xf9, 0x8c,
+	0xcd, 0xaf, 0x79, 0x52, 0x04, 0x29, 0x0e, 0x49,
+	0x60, 0xdf, 0x86, 0x00, 0xee, 0xe8, 0x87, 0x9c,
+	0x69, 0x1d, 0xb8, 0xe8, 0xe4, 0x3e, 0xe0, 0x98,
+	0xda, 0xfa, 0x63, 0x38, 0xfd, 0x96, 0xe4, 0xe3,
+	0x4a, 0x20, 0x67, 0x5e, 0xb9, 0x99, 0xc3, 0xeb,
+	0x5b, 0x6d, 0x2a, 0xb2, 0x48, 0xa6, 0x03, 0x96,
+	0x14, 0x3e, 0xe8, 0x13, 0xab, 0x9b, 0x16, 0xa8,
+	0xd2, 0x48, 0xf6, 0x4c, 0x6b, 0x63, 0xda, 0x0f,
+	0xea, 0x25, 0xb6, 0x9c, 0x1d, 0xa8, 0xf7, 0xac,
+	0xf4, 0xde, 0x3b, 0xfa, 0x5f, 0x9b, 0xd2, 0x47,
+	0x0d, 0xb7, 0x1f, 0x80, 0x0c, 0xaf, 0xb8, 0x7a,
+	0x7f, 0x9c, 0xec, 0x0c, 0x3c, 0xbe, 0x9d, 0x2a,
+	0xe7, 0x95, 0xfc, 0x73, 0xb6, 0xbc, 0x2c, 0x79,
+};
+
+static bool __init blake2bp_selftest_one(struct blake2bp_state *S,
+					 const u8 *key, const u8 *in,
+					 size_t len, size_t split,
+					 const u8 *want,
+					 int (*update)(struct blake2bp_state *,
+						       const void *, size_t),
+					 int (*final)(struct blake2bp_state *,
+						      void *, size_t))
+{
+	u8 out[BLAKE2B_OUTBYTES];
+
+	blake2bp_init_key(S, BLAKE2B_OUTBYTES, key, BLAKE2B_KEYBYTES);
+	update(S, in, split);
+	update(S, in + split, len - split);
+	final(S, out, BLAKE2B_OUTBYTES);
+	return !memcmp(out, want, BLAKE2B_OUTBYTES);
+}
+
+static int __init blake2bp_selftest(const u8 *key, const u8 *in)
+{
+	struct blake2bp_state *S;
+	size_t i, len;
+	int ret = 0;
+
+	S = kmalloc(sizeof(*S), GFP_KERNEL);
+	if (!S)
+		return -ENOMEM;
+
+	for (i = 0; i < ARRAY_SIZE(blake2bp_kat_len); i++) {
+		len = blake2bp_kat_len[i];
+		if (blake2bp_selftest_one(S, key, in, len, 0, blake2bp_kat[i],
+					  blake2bp_update, blake2bp_final) &&
+		    blake2bp_selftest_one(S, key, in, len, len / 3,
+					  blake2bp_kat[i], blake2bp_update,
+					  blake2bp_final) &&
+		    blake2bp_selftest_one(S, key, in, len, 0, blake2bp_kat[i],
+					  blake2bp_update_arch,
+					  blake2bp_final_arch) &&
+		    blake2bp_selftest_one(S, key, in, len, len / 3,
+					  blake2bp_kat[i],
+					  blake2bp_update_arch,
+					  blake2bp_final_arch))
+			continue;
+		pr_err("blake2bp: KAT of %zu bytes failed\n", len);
+		ret = -EINVAL;
+	}
+
+	kfree_sensitive(S);
+	return ret;
+}
+
+static void __init blake2xb_selftest_one(struct blake2xb_state *S,
+					 const u8 *key, const u8 *in,
+					 size_t xof_length, u8 *out,
+					 size_t outlen, bool arch)
+{
+	blake2xb_init_key(S, xof_length, key, BLAKE2B_KEYBYTES);
+	if (arch) {
+		blake2xb_update(S, in, BLAKE2XB_SELFTEST_INLEN);
+		blake2xb_final(S, out, outlen);
+	} else {
+		blake2b_update(S->S, in, BLAKE2XB_SELFTEST_INLEN);
+		__blake2xb_final(S, out, outlen, blake2b_final,
+				 blake2xb_blocks_generic);
+	}
+}
+
+/* out[0..len) is from the generic blocks, out[len..2 * len) from _arch */
+static int __init blake2xb_selftest(const u8 *key, const u8 *in)
+{
+	const u8 *want = blake2xb_kat;
+	struct blake2xb_state *S;
+	size_t i, len;
+	int ret = 0;
+	u8 *out;
+
+	S = kmalloc(sizeof(*S), GFP_KERNEL);
+	out = kmalloc(2 * BLAKE2XB_SELFTEST_LONG, GFP_KERNEL);
+	if (!S || !out) {
+		ret = -ENOMEM;
+		goto free;
+	}
+
+	for (i = 0; i < ARRAY_SIZE(blake2xb_kat_len); i++) {
+		len = blake2xb_kat_len[i];
+		blake2xb_selftest_one(S, key, in, len, out, len, false);
+		blake2xb_selftest_one(S, key, in, len, out + len, len, true);
+		if (memcmp(out, want, len) || memcmp(out + len, want, len)) {
+			pr_err("blake2xb: KAT of %zu bytes failed\n", len);
+			ret = -EINVAL;
+		}
+		want += len;
+	}
+
+	len = BLAKE2XB_SELFTEST_UNKNOWN;
+	blake2xb_selftest_one(S, key, in, BLAKE2XB_UNKNOWN_LENGTH, out, len,
+			      false);
+	blake2xb_selftest_one(S, key, in, BLAKE2XB_UNKNOWN_LENGTH, out + len,
+			      len, true);
+	if (memcmp(out, blake2xb_kat_unknown, len) ||
+	    memcmp(out + len, blake2xb_kat_unknown, len)) {
+		pr_err("blake2xb: KAT of unknown length failed\n");
+		ret = -EINVAL;
+	}
+
+	/* More output blocks than lanes, with a partial last one */
+	len = BLAKE2XB_SELFTEST_LONG;
+	blake2xb_selftest_one(S, key, in, len, out, len, false);
+	blake2xb_selftest_one(S, key, in, len, out + len, len, true);
+	if (memcmp(out, out + len, len)) {
+		pr_err("blake2xb: _arch output of %zu bytes differs\n", len);
+		ret = -EINVAL;
+	}
+
+free:
+	kfree(out);
+	kfree_sensitive(S);
+	return ret;
+}
+
+#ifdef BLAKE2B_SIMD
+/* More states than lanes, so the lanes are refilled */
+#define BLAKE2B_SELFTEST_MANY	(2 * BLAKE2B_MB_LANES + 3)
+
+/* State i of the update_many test, keys, salts and digest lengths all differ */
+static void __init blake2b_many_init(struct blake2b_state *S, unsigned int i,
+				     const u8 *key, const u8 *in)
+{
+	blake2b_init_salt_personal(S, 1 + i * 7 % BLAKE2B_OUTBYTES, key,
+				   i % (BLAKE2B_KEYBYTES + 1), in + i,
+				   in + 2 * i);
+}
+
+/*
+ * blake2b_update_many() in one call and in two, against separate updates of
+ * the same states
+ */
+static int __init blake2b_many_selftest(const u8 *key, const u8 *in)
+{
+	static const u16 split[] __initconst = { 0, 1, 127, 1000 };
+	struct blake2b_state *P[BLAKE2B_SELFTEST_MANY];
+	const size_t len = BLAKE2B_SELFTEST_MAXLEN;
+	u8 want[BLAKE2B_OUTBYTES];
+	u8 out[BLAKE2B_OUTBYTES];
+	struct blake2b_state *S;
+	unsigned int i, j;
+	size_t outlen;
+	int ret = 0;
+
+	/* S[i] goes through update_many, S[i + MANY] is its reference */
+	S = kmalloc_array(2 * BLAKE2B_SELFTEST_MANY, sizeof(*S), GFP_KERNEL);
+	if (!S)
+		return -ENOMEM;
+
+	for (j = 0; j < ARRAY_SIZE(split); j++) {
+		for (i = 0; i < BLAKE2B_SELFTEST_MANY; i++) {
+			blake2b_many_init(&S[i], i, key, in);
+			P[i] = &S[i];
+		}
+		blake2b_update_many(P, BLAKE2B_SELFTEST_MANY, in, split[j]);
+		blake2b_update_many(P, BLAKE2B_SELFTEST_MANY, in + split[j],
+				    len - split[j]);
+
+		for (i = 0; i < BLAKE2B_SELFTEST_MANY; i++) {
+			P[i] = &S[i + BLAKE2B_SELFTEST_MANY];
+			blake2b_many_init(P[i], i, key, in);
+			blake2b_update(P[i], in, len);
+			outlen = P[i]->outlen;
+			blake2b_final(P[i], want, sizeof(want));
+			blake2b_final(&S[i], out, sizeof(out));
+			if (memcmp(out, want, outlen)) {
+				pr_err("blake2b: update_many of state %u split at %u failed\n",
+				       i, split[j]);
+				ret = -EINVAL;
+			}
+		}
+	}
+
+	kfree_sensitive(S);
+	return ret;
+}
+
+/* Sectors of two blocks, the last one partial, more of them than lanes */
+#define BLAKE2B_SELFTEST_SECTOR		150
+#define BLAKE2B_SELFTEST_SECTORS	(BLAKE2B_MB_LANES + 3)
+
+/*
+ * digest_sectors and verify_sectors against blake2b() of each sector,
+ * verify gets one wrong checksum
+ */
+static int __init blake2b_sectors_selftest(const u8 *key, const u8 *in)
+{
+	const unsigned int count = BLAKE2B_SELFTEST_SECTORS;
+	const size_t size = BLAKE2B_SELFTEST_SECTOR;
+	DECLARE_BITMAP(mismatch, BLAKE2B_SELFTEST_SECTORS);
+	unsigned int nr_mismatch, i, k;
+	size_t keylen, outlen;
+	u8 *want, *out;
+	int ret = 0;
+
+	want = kmalloc_array(2 * count, BLAKE2B_OUTBYTES, GFP_KERNEL);
+	if (!want)
+		return -ENOMEM;
+	out = want + count * BLAKE2B_OUTBYTES;
+
+	for (k = 0; k < 2; k++) {
+		keylen = k ? BLAKE2B_KEYBYTES : 0;
+		outlen = k ? BLAKE2B_OUTBYTES : BLAKE2B_OUTBYTES / 2;
+		for (i = 0; i < count; i++) {
+			blake2b(want + i * outlen, in + i * size, key, outlen,
+				size, keylen);
+		}
+
+		if (blake2b_digest_sectors(in, size, count, key, keylen, out,
+					   outlen) ||
+		    memcmp(out, want, count * outlen)) {
+			pr_err("blake2b: digest_sectors with a key of %zu bytes failed\n",
+			       keylen);
+			ret = -EINVAL;
+		}
+
+		want[3 * outlen] ^= 1;
+		if (blake2b_verify_sectors(in, size, count, key, keylen, want,
+					   outlen, mismatch, &nr_mismatch) ||
+		    nr_mismatch != 1 || bitmap_weight(mismatch, count) != 1 ||
+		    !test_bit(3, mismatch)) {
+			pr_err("blake2b: verify_sectors with a key of %zu bytes failed\n",
+			       keylen);
+			ret = -EINVAL;
+		}
+	}
+
+	kfree(want);
+	return ret;
+}
+#else
+#define blake2b_many_selftest(key, in)		(0)
+#define blake2b_sectors_selftest(key, in)	(0)
+#endif
+
+static int __init blake2b_selftest(void)
+{
+	u8 key[BLAKE2B_KEYBYTES];
+	size_t i;
+	u8 *in;
+	int ret;
+
+	if (IS_ENABLED(CONFIG_CRYPTO_MANAGER_DISABLE_TESTS))
+		return 0;
+
+	in = kmalloc(BLAKE2B_SELFTEST_MAXLEN, GFP_KERNEL);
+	if (!in)
+		return -ENOMEM;
+	for (i = 0; i < BLAKE2B_SELFTEST_MAXLEN; i++)
+		in[i] = (u8)i;
+	for (i = 0; i < BLAKE2B_KEYBYTES; i++)
+		key[i] = (u8)i;
+
+	ret = blake2bp_selftest(key, in) ?: blake2xb_selftest(key, in) ?:
+	      blake2b_many_selftest(key, in) ?:
+	      blake2b_sectors_selftest(key, in);
+
+	kfree(in);
+	return ret;
+}
@@ -0,0 +1,198 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * Tree mode BLAKE2b over a scatterlist, included by blake2b-glue.c
+ *
+ * The message is cut into leaves of BLAKE2B_TREE_LEAFBYTES, the depth 0
+ * nodes of a depth 2 tree with unlimited fanout. The root hashes the leaf
+ * digests in order. Large inputs spread ranges of leaves over a workqueue,
+ * the digest does not depend on how the leaves were scheduled.
+ */
+
+#include <linux/cpumask.h>
+#include <linux/scatterlist.h>
+
+static unsigned int tree_parallel_min = SZ_1M;
+module_param(tree_parallel_min, uint, 0644);
+MODULE_PARM_DESC(tree_parallel_min, "Smallest input of blake2b_tree_digest() that is hashed on several CPUs");
+
+static struct workqueue_struct *blake2b_tree_wq;
+
+struct blake2b_tree {
+	struct scatterlist *sg;
+	unsigned int nbytes;
+	const u8 *key;
+	unsigned int keylen;
+	unsigned int outlen;
+	unsigned int nleaves;
+	u8 (*digests)[BLAKE2B_OUTBYTES];
+};
+
+/* Leaves first to first + count - 1 */
+struct blake2b_tree_job {
+	struct work_struct work;
+	const struct blake2b_tree *tree;
+	unsigned int first;
+	unsigned int count;
+};
+
+static void blake2b_tree_init_node(struct blake2b_state *S,
+				   const struct blake2b_tree *tree,
+				   u32 offset, u8 depth)
+{
+	struct blake2b_param P[1];
+
+	P->digest_length = (u8)tree->outlen;
+	P->key_length    = (u8)tree->keylen;
+	P->fanout        = 0;
+	P->depth         = 2;
+	store32(&P->leaf_length, BLAKE2B_TREE_LEAFBYTES);
+	store32(&P->node_offset, offset);
+	store32(&P->xof_length, 0);
+	P->node_depth    = depth;
+	P->inner_length  = BLAKE2B_OUTBYTES;
+	memset(P->reserved, 0, sizeof(P->reserved));
+	memset(P->salt,     0, sizeof(P->salt));
+	memset(P->personal, 0, sizeof(P->personal));
+	blake2b_init_param(S, P);
+}
+
+static void blake2b_tree_leaves(struct blake2b_tree_job *job)
+{
+	const struct blake2b_tree *tree = job->tree;
+	size_t off = (size_t)job->first * BLAKE2B_TREE_LEAFBYTES;
+	struct sg_mapping_iter miter;
+	struct blake2b_state S;
+	unsigned int leaf;
+
+	sg_miter_start(&miter, tree->sg, sg_nents(tree->sg), SG_MITER_FROM_SG);
+	sg_miter_skip(&miter, off);
+
+	for (leaf = job->first; leaf < job->first + job->count; leaf++) {
+		size_t left = min_t(size_t, tree->nbytes - off,
+				    BLAKE2B_TREE_LEAFBYTES);
+
+		blake2b_tree_init_node(&S, tree, leaf, 0);
+		/* The leaves output the full inner length */
+		S.outlen = BLAKE2B_OUTBYTES;
+		if (leaf == tree->nleaves - 1)
+			S.last_node = 1;
+
+		/* Only the leaves hash the key block */
+		if (tree->keylen) {
+			u8 block[BLAKE2B_BLOCKBYTES];
+
+			memset(block, 0, BLAKE2B_BLOCKBYTES);
+			memcpy(block, tree->key, tree->keylen);
+			blake2b_update_arch(&S, block, BLAKE2B_BLOCKBYTES);
+			memzero_explicit(block, BLAKE2B_BLOCKBYTES);
+		}
+
+		off += left;
+		while (left && sg_miter_next(&miter)) {
+			size_t len = min_t(size_t, miter.length, left);
+
+			blake2b_update_arch(&S, miter.addr, len);
+			miter.consumed = len;
+			left -= len;
+		}
+		blake2b_final_arch(&S, tree->digests[leaf], BLAKE2B_OUTBYTES);
+	}
+	sg_miter_stop(&miter);
+	memzero_explicit(&S, sizeof(S));
+}
+
+static void blake2b_tree_work(struct work_struct *work)
+{
+	blake2b_tree_leaves(container_of(work, struct blake2b_tree_job, work));
+}
+
+/**
+ * blake2b_tree_digest - tree mode BLAKE2b of a scatterlist
+ * @sg: the message
+ * @nbytes: length of the message
+ * @key: the key, NULL if unkeyed
+ * @keylen: length of the key, 0 to BLAKE2B_KEYBYTES
+ * @out: the digest
+ * @outlen: digest length, 1 to BLAKE2B_OUTBYTES
+ *
+ * Inputs of at least tree_parallel_min bytes have their leaves hashed on up
+ * to one CPU each, smaller inputs are hashed by the caller. The digest is
+ * the same either way and differs from a plain blake2b() of the message.
+ * Sleeps, the pages of sg are mapped with kmap.
+ */
+int blake2b_tree_digest(struct scatterlist *sg, unsigned int nbytes,
+			const u8 *key, unsigned int keylen, u8 *out,
+			unsigned int outlen)
+{
+	struct blake2b_tree tree = {
+		.sg	= sg,
+		.nbytes	= nbytes,
+		.key	= key,
+		.keylen	= keylen,
+		.outlen	= outlen,
+		.nleaves = max(DIV_ROUND_UP(nbytes, BLAKE2B_TREE_LEAFBYTES), 1U),
+	};
+	struct blake2b_tree_job *jobs;
+	struct blake2b_state R;
+	unsigned int njobs = 1;
+	unsigned int per;
+	unsigned int i;
+	int ret = 0;
+
+	if (!outlen || outlen > BLAKE2B_OUTBYTES)
+		return -EINVAL;
+	if (keylen > BLAKE2B_KEYBYTES || (keylen && !key))
+		return -EINVAL;
+
+	if (nbytes >= READ_ONCE(tree_parallel_min))
+		njobs = min(tree.nleaves, num_online_cpus());
+	per = DIV_ROUND_UP(tree.nleaves, njobs);
+	njobs = DIV_ROUND_UP(tree.nleaves, per);
+
+	tree.digests = kvmalloc_array(tree.nleaves, BLAKE2B_OUTBYTES, GFP_KERNEL);
+	jobs = kcalloc(njobs, sizeof(*jobs), GFP_KERNEL);
+	if (!tree.digests || !jobs) {
+		ret = -ENOMEM;
+		goto out;
+	}
+
+	for (i = 0; i < njobs; i++) {
+		jobs[i].tree = &tree;
+		jobs[i].first = i * per;
+		jobs[i].count = min(per, tree.nleaves - i * per);
+	}
+	/* The caller takes the first range */
+	for (i = 1; i < njobs; i++) {
+		INIT_WORK(&jobs[i].work, blake2b_tree_work);
+		queue_work(blake2b_tree_wq, &jobs[i].work);
+	}
+	blake2b_tree_leaves(&jobs[0]);
+	for (i = 1; i < njobs; i++)
+		flush_work(&jobs[i].work);
+
+	blake2b_tree_init_node(&R, &tree, 0, 1);
+	R.last_node = 1;
+	blake2b_update_arch(&R, tree.digests,
+			    (size_t)tree.nleaves * BLAKE2B_OUTBYTES);
+	blake2b_final_arch(&R, out, outlen);
+	memzero_explicit(&R, sizeof(R));
+
+out:
+	kfree(jobs);
+	kvfree_sensitive(tree.digests, (size_t)tree.nleaves * BLAKE2B_OUTBYTES);
+	return ret;
+}
+EXPORT_SYMBOL_GPL(blake2b_tree_digest);
+
+static int __init blake2b_tree_init(void)
+{
+	blake2b_tree_wq = alloc_workqueue("blake2b_tree", WQ_UNBOUND, 0);
+	if (!blake2b_tree_wq)
+		return -ENOMEM;
+	return 0;
+}
+
+static void blake2b_tree_exit(void)
+{
+	destroy_workqueue(blake2b_tree_wq);
+}
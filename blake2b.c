@@ -25,10 +25,8 @@
 
 static const u64 blake2b_IV[8] =
 {
-	0x6a09e667f3bcc908ULL, 0xbb67ae8584caa73bULL,
-	0x3c6ef372fe94f82bULL, 0xa54ff53a5f1d36f1ULL,
-	0x510e527fade682d1ULL, 0x9b05688c2b3e6c1fULL,
-	0x1f83d9abfb41bd6bULL, 0x5be0cd19137e2179ULL
+	BLAKE2B_IV0, BLAKE2B_IV1, BLAKE2B_IV2, BLAKE2B_IV3,
+	BLAKE2B_IV4, BLAKE2B_IV5, BLAKE2B_IV6, BLAKE2B_IV7
 };
 
 static const u8 blake2b_sigma[12][16] =
@@ -98,37 +96,20 @@ int blake2b_init_param(struct blake2b_state *S, const struct blake2b_param *P)
 	return 0;
 }
 
-int blake2b_init(struct blake2b_state *S, size_t outlen)
-{
-	struct blake2b_param P[1];
-
-	if ((!outlen) || (outlen > BLAKE2B_OUTBYTES))
-		return -1;
-
-	P->digest_length = (u8)outlen;
-	P->key_length    = 0;
-	P->fanout        = 1;
-	P->depth         = 1;
-	store32(&P->leaf_length, 0);
-	store32(&P->node_offset, 0);
-	store32(&P->xof_length, 0);
-	P->node_depth    = 0;
-	P->inner_length  = 0;
-	memset(P->reserved, 0, sizeof(P->reserved));
-	memset(P->salt,     0, sizeof(P->salt));
-	memset(P->personal, 0, sizeof(P->personal));
-	return blake2b_init_param(S, P);
-}
-
-int blake2b_init_key(struct blake2b_state *S, size_t outlen, const void *key,
-		     size_t keylen)
+/*
+ * Keyed or unkeyed (keylen 0) with salt and personalization, a NULL salt or
+ * personal is all zeros
+ */
+int blake2b_init_salt_personal(struct blake2b_state *S, size_t outlen,
+			       const void *key, size_t keylen,
+			       const void *salt, const void *personal)
 {
 	struct blake2b_param P[1];
 
 	if ((!outlen) || (outlen > BLAKE2B_OUTBYTES))
 		return -1;
 
-	if (!key || !keylen || keylen > BLAKE2B_KEYBYTES)
+	if (keylen > BLAKE2B_KEYBYTES || (keylen && !key))
 		return -1;
 
 	P->digest_length = (u8)outlen;
@@ -141,13 +122,19 @@ int blake2b_init_key(struct blake2b_state *S, size_t outlen, const void *key,
 	P->node_depth    = 0;
 	P->inner_length  = 0;
 	memset(P->reserved, 0, sizeof(P->reserved));
-	memset(P->salt,     0, sizeof(P->salt));
-	memset(P->personal, 0, sizeof(P->personal));
+	if (salt)
+		memcpy(P->salt, salt, sizeof(P->salt));
+	else
+		memset(P->salt, 0, sizeof(P->salt));
+	if (personal)
+		memcpy(P->personal, personal, sizeof(P->personal));
+	else
+		memset(P->personal, 0, sizeof(P->personal));
 
 	if (blake2b_init_param(S, P) < 0)
 		return -1;
 
-	{
+	if (keylen) {
 		u8 block[BLAKE2B_BLOCKBYTES];
 
 		memset(block, 0, BLAKE2B_BLOCKBYTES);
@@ -158,6 +145,20 @@ int blake2b_init_key(struct blake2b_state *S, size_t outlen, const void *key,
 	return 0;
 }
 
+int blake2b_init(struct blake2b_state *S, size_t outlen)
+{
+	return blake2b_init_salt_personal(S, outlen, NULL, 0, NULL, NULL);
+}
+
+int blake2b_init_key(struct blake2b_state *S, size_t outlen, const void *key,
+		     size_t keylen)
+{
+	if (!key || !keylen)
+		return -1;
+
+	return blake2b_init_salt_personal(S, outlen, key, keylen, NULL, NULL);
+}
+
 #define G(r,i,a,b,c,d)                                  \
 	do {                                            \
 		a = a + b + m[blake2b_sigma[r][2*i+0]]; \
@@ -182,49 +183,68 @@ int blake2b_init_key(struct blake2b_state *S, size_t outlen, const void *key,
 		G(r,7,v[ 3],v[ 4],v[ 9],v[14]); \
 	} while(0)
 
-static void blake2b_compress(struct blake2b_state *S,
-			     const u8 block[BLAKE2B_BLOCKBYTES])
+/*
+ * Compress nblocks consecutive blocks, adding inc to the counter before each
+ * one. The finalization flags are set by the caller.
+ */
+static void blake2b_compress_generic(struct blake2b_state *S, const u8 *block,
+				     size_t nblocks, u32 inc)
 {
 	u64 m[16];
 	u64 v[16];
 	size_t i;
 
-	for (i = 0; i < 16; ++i)
-		m[i] = load64(block + i * sizeof(m[i]));
-
-	for (i = 0; i < 8; ++i)
-		v[i] = S->h[i];
-
-	v[ 8] = blake2b_IV[0];
-	v[ 9] = blake2b_IV[1];
-	v[10] = blake2b_IV[2];
-	v[11] = blake2b_IV[3];
-	v[12] = blake2b_IV[4] ^ S->t[0];
-	v[13] = blake2b_IV[5] ^ S->t[1];
-	v[14] = blake2b_IV[6] ^ S->f[0];
-	v[15] = blake2b_IV[7] ^ S->f[1];
-
-	ROUND(0);
-	ROUND(1);
-	ROUND(2);
-	ROUND(3);
-	ROUND(4);
-	ROUND(5);
-	ROUND(6);
-	ROUND(7);
-	ROUND(8);
-	ROUND(9);
-	ROUND(10);
-	ROUND(11);
-
-	for (i = 0; i < 8; ++i)
-		S->h[i] = S->h[i] ^ v[i] ^ v[i + 8];
+	while (nblocks--) {
+		blake2b_increment_counter(S, inc);
+
+		for (i = 0; i < 16; ++i)
+			m[i] = load64(block + i * sizeof(m[i]));
+
+		for (i = 0; i < 8; ++i)
+			v[i] = S->h[i];
+
+		v[ 8] = blake2b_IV[0];
+		v[ 9] = blake2b_IV[1];
+		v[10] = blake2b_IV[2];
+		v[11] = blake2b_IV[3];
+		v[12] = blake2b_IV[4] ^ S->t[0];
+		v[13] = blake2b_IV[5] ^ S->t[1];
+		v[14] = blake2b_IV[6] ^ S->f[0];
+		v[15] = blake2b_IV[7] ^ S->f[1];
+
+		ROUND(0);
+		ROUND(1);
+		ROUND(2);
+		ROUND(3);
+		ROUND(4);
+		ROUND(5);
+		ROUND(6);
+		ROUND(7);
+		ROUND(8);
+		ROUND(9);
+		ROUND(10);
+		ROUND(11);
+
+		for (i = 0; i < 8; ++i)
+			S->h[i] = S->h[i] ^ v[i] ^ v[i + 8];
+
+		block += BLAKE2B_BLOCKBYTES;
+	}
 }
 
 #undef G
 #undef ROUND
 
-int blake2b_update(struct blake2b_state *S, const void *pin, size_t inlen)
+typedef void (*blake2b_compress_t)(struct blake2b_state *S, const u8 *block,
+				   size_t nblocks, u32 inc);
+
+/*
+ * The update and final bodies are shared by the generic and SIMD builds, the
+ * compress function is a compile-time constant so the calls stay direct.
+ */
+static __always_inline int __blake2b_update(struct blake2b_state *S,
+					    const void *pin, size_t inlen,
+					    blake2b_compress_t compress)
 {
 	const unsigned char *in = (const unsigned char *)pin;
 
@@ -236,16 +256,17 @@ int blake2b_update(struct blake2b_state *S, const void *pin, size_t inlen)
 			S->buflen = 0;
 			/* Fill buffer */
 			memcpy(S->buf + left, in, fill);
-			blake2b_increment_counter(S, BLAKE2B_BLOCKBYTES);
 			/* Compress */
-			blake2b_compress(S, S->buf);
+			compress(S, S->buf, 1, BLAKE2B_BLOCKBYTES);
 			in += fill;
 			inlen -= fill;
-			while (inlen > BLAKE2B_BLOCKBYTES) {
-				blake2b_increment_counter(S, BLAKE2B_BLOCKBYTES);
-				blake2b_compress(S, in);
-				in += BLAKE2B_BLOCKBYTES;
-				inlen -= BLAKE2B_BLOCKBYTES;
+			if (inlen > BLAKE2B_BLOCKBYTES) {
+				/* All but the last block, it may be the final one */
+				size_t nblocks = DIV_ROUND_UP(inlen, BLAKE2B_BLOCKBYTES) - 1;
+
+				compress(S, in, nblocks, BLAKE2B_BLOCKBYTES);
+				in += nblocks * BLAKE2B_BLOCKBYTES;
+				inlen -= nblocks * BLAKE2B_BLOCKBYTES;
 			}
 		}
 		memcpy(S->buf + S->buflen, in, inlen);
@@ -254,64 +275,223 @@ int blake2b_update(struct blake2b_state *S, const void *pin, size_t inlen)
 	return 0;
 }
 
-int blake2b_final(struct blake2b_state *S, void *out, size_t outlen)
+/* Output the words covering the digest */
+static void blake2b_output(const struct blake2b_state *S, u8 *out)
 {
-	u8 buffer[BLAKE2B_OUTBYTES] = {0};
+	u8 buffer[BLAKE2B_OUTBYTES];
 	size_t i;
 
+	for (i = 0; i < DIV_ROUND_UP(S->outlen, sizeof(S->h[i])); ++i)
+		store64(buffer + sizeof(S->h[i]) * i, S->h[i]);
+
+	memcpy(out, buffer, S->outlen);
+	memzero_explicit(buffer, sizeof(buffer));
+}
+
+static __always_inline int __blake2b_final(struct blake2b_state *S, void *out,
+					   size_t outlen,
+					   blake2b_compress_t compress)
+{
 	if (out == NULL || outlen < S->outlen)
 		return -1;
 
 	if (blake2b_is_lastblock(S))
 		return -1;
 
-	blake2b_increment_counter(S, S->buflen);
 	blake2b_set_lastblock(S);
 	/* Padding */
 	memset(S->buf + S->buflen, 0, BLAKE2B_BLOCKBYTES - S->buflen);
-	blake2b_compress(S, S->buf);
+	compress(S, S->buf, 1, S->buflen);
 
-	/* Output full hash to temp buffer */
-	for (i = 0; i < 8; ++i)
-		store64(buffer + sizeof(S->h[i]) * i, S->h[i]);
+	blake2b_output(S, out);
+	return 0;
+}
 
-	memcpy(out, buffer, S->outlen);
-	memzero_explicit(buffer, sizeof(buffer));
+/*
+ * Hash the remaining input and finalize. Full blocks, including the last
+ * one, are compressed from the caller's buffer and only a partial tail is
+ * padded in a stack block.
+ */
+static __always_inline int __blake2b_finup(struct blake2b_state *S,
+					   const u8 *in, size_t inlen, u8 *out,
+					   blake2b_compress_t compress)
+{
+	u8 block[BLAKE2B_BLOCKBYTES];
+	size_t left = S->buflen;
+
+	if (blake2b_is_lastblock(S))
+		return -1;
+
+	/* Complete the buffered block, it is not the last one */
+	if (left) {
+		size_t fill = BLAKE2B_BLOCKBYTES - left;
+
+		if (inlen <= fill) {
+			memcpy(S->buf + left, in, inlen);
+			S->buflen += inlen;
+			return __blake2b_final(S, out, S->outlen, compress);
+		}
+		memcpy(S->buf + left, in, fill);
+		compress(S, S->buf, 1, BLAKE2B_BLOCKBYTES);
+		S->buflen = 0;
+		in += fill;
+		inlen -= fill;
+	}
+
+	if (inlen > BLAKE2B_BLOCKBYTES) {
+		size_t nblocks = DIV_ROUND_UP(inlen, BLAKE2B_BLOCKBYTES) - 1;
+
+		compress(S, in, nblocks, BLAKE2B_BLOCKBYTES);
+		in += nblocks * BLAKE2B_BLOCKBYTES;
+		inlen -= nblocks * BLAKE2B_BLOCKBYTES;
+	}
+
+	blake2b_set_lastblock(S);
+	if (inlen == BLAKE2B_BLOCKBYTES) {
+		compress(S, in, 1, BLAKE2B_BLOCKBYTES);
+	} else {
+		memcpy(block, in, inlen);
+		memset(block + inlen, 0, BLAKE2B_BLOCKBYTES - inlen);
+		compress(S, block, 1, inlen);
+		memzero_explicit(block, sizeof(block));
+	}
+
+	blake2b_output(S, out);
 	return 0;
 }
 
+int blake2b_update(struct blake2b_state *S, const void *pin, size_t inlen)
+{
+	return __blake2b_update(S, pin, inlen, blake2b_compress_generic);
+}
+
+int blake2b_final(struct blake2b_state *S, void *out, size_t outlen)
+{
+	return __blake2b_final(S, out, outlen, blake2b_compress_generic);
+}
+
+static int blake2b_finup(struct blake2b_state *S, const u8 *in, size_t inlen,
+			 u8 *out)
+{
+	return __blake2b_finup(S, in, inlen, out, blake2b_compress_generic);
+}
+
+#ifdef BLAKE2B_SIMD
+/* Defined in blake2b-glue.c after including this file */
+static int blake2b_update_arch(struct blake2b_state *S, const void *pin,
+			       size_t inlen);
+static int blake2b_final_arch(struct blake2b_state *S, void *out, size_t outlen);
+static int blake2b_finup_arch(struct blake2b_state *S, const u8 *in,
+			      size_t inlen, u8 *out);
+static int blake2b_arch_init(struct shash_alg *algs, int count);
+static void blake2b_arch_exit(void);
+#else
+#define blake2b_arch_init(algs, count)	(0)
+#define blake2b_arch_exit()		do { } while (0)
+#define blake2b_update_arch		blake2b_update
+#define blake2b_final_arch		blake2b_final
+#define blake2b_finup_arch		blake2b_finup
+#endif
+
+void blake2b_lib_update(struct blake2b_state *S, const u8 *in, size_t inlen)
+{
+	blake2b_update_arch(S, in, inlen);
+}
+
+void blake2b_lib_final(struct blake2b_state *S, u8 *out)
+{
+	blake2b_final_arch(S, out, S->outlen);
+	memzero_explicit(S, sizeof(*S));
+}
+
+/* The one-shot path of blake2b(), no copy of full blocks */
+void blake2b_lib_finup(struct blake2b_state *S, const u8 *in, size_t inlen,
+		       u8 *out)
+{
+	blake2b_finup_arch(S, in, inlen, out);
+	memzero_explicit(S, sizeof(*S));
+}
+
+/* Only one of the generic and the SIMD module may export them */
+#ifdef BLAKE2B_SIMD
+EXPORT_SYMBOL_GPL(blake2b_lib_update);
+EXPORT_SYMBOL_GPL(blake2b_lib_final);
+EXPORT_SYMBOL_GPL(blake2b_lib_finup);
+#endif
+
 struct chksum_desc_ctx {
 	struct blake2b_state S[1];
 };
 
+/*
+ * S is the IV xor the parameter block, after the key block when keyed, so
+ * init is a copy. The key block is only the last block of an empty message,
+ * that digest is kept aside in empty.
+ */
 struct chksum_ctx {
-	u8 key[BLAKE2B_KEYBYTES];
+	struct blake2b_state S[1];
+	u8 empty[BLAKE2B_OUTBYTES];
+	unsigned int keylen;
 };
 
 static int chksum_init(struct shash_desc *desc)
 {
 	struct chksum_ctx *mctx = crypto_shash_ctx(desc->tfm);
 	struct chksum_desc_ctx *ctx = shash_desc_ctx(desc);
-	int ret;
 
-	ret = blake2b_init_key(ctx->S, BLAKE2B_OUTBYTES, mctx->key, BLAKE2B_KEYBYTES);
-	if (ret)
+	*ctx->S = *mctx->S;
+	return 0;
+}
+
+/* A plain key or a struct blake2b_setkey_param, also used by the SIMD ahash */
+static int blake2b_ctx_setkey(struct chksum_ctx *mctx, unsigned int digestsize,
+			      const u8 *key, unsigned int keylen)
+{
+	struct blake2b_state *S = mctx->S;
+	const u8 *salt = NULL, *personal = NULL;
+	struct blake2b_state tmp;
+
+	/* The extended format may leave the key out */
+	if (keylen == sizeof(struct blake2b_setkey_param)) {
+		const struct blake2b_setkey_param *param = (const void *)key;
+
+		key = param->key;
+		keylen = param->keylen;
+		salt = param->salt;
+		personal = param->personal;
+	}
+	if ((!keylen && !salt) || keylen > BLAKE2B_KEYBYTES)
 		return -EINVAL;
+	if (blake2b_init_salt_personal(S, digestsize, key, keylen, salt,
+				       personal))
+		return -EINVAL;
+
+	mctx->keylen = keylen;
+	if (!keylen)
+		return 0;
 
+	/* The key block is buffered, finalize a copy for the empty message */
+	tmp = *S;
+	blake2b_final(&tmp, mctx->empty, S->outlen);
+	memzero_explicit(&tmp, sizeof(tmp));
+
+	/* Any data follows the key block, compress it now */
+	blake2b_compress_generic(S, S->buf, 1, BLAKE2B_BLOCKBYTES);
+	memzero_explicit(S->buf, sizeof(S->buf));
+	S->buflen = 0;
 	return 0;
 }
 
 static int chksum_setkey(struct crypto_shash *tfm, const u8 *key,
 			 unsigned int keylen)
 {
-	struct chksum_ctx *mctx = crypto_shash_ctx(tfm);
+	int ret;
 
-	if (keylen != BLAKE2B_KEYBYTES) {
+	ret = blake2b_ctx_setkey(crypto_shash_ctx(tfm),
+				 crypto_shash_digestsize(tfm), key, keylen);
+	if (ret)
 		crypto_shash_set_flags(tfm, CRYPTO_TFM_RES_BAD_KEY_LEN);
-		return -EINVAL;
-	}
-	memcpy(mctx->key, key, BLAKE2B_KEYBYTES);
-	return 0;
+	return ret;
 }
 
 static int chksum_update(struct shash_desc *desc, const u8 *data,
@@ -320,85 +500,229 @@ static int chksum_update(struct shash_desc *desc, const u8 *data,
 	struct chksum_desc_ctx *ctx = shash_desc_ctx(desc);
 	int ret;
 
-	ret = blake2b_update(ctx->S, data, length);
+	ret = blake2b_update_arch(ctx->S, data, length);
 	if (ret)
 		return -EINVAL;
 	return 0;
 }
 
-static int chksum_final(struct shash_desc *desc, u8 *out)
+static int blake2b_ctx_final(const struct chksum_ctx *mctx,
+			     struct blake2b_state *S, u8 *out)
 {
-	struct chksum_desc_ctx *ctx = shash_desc_ctx(desc);
 	int ret;
 
-	ret = blake2b_final(ctx->S, out, BLAKE2B_OUTBYTES);
+	/* Keyed state that has not seen any data since the key block */
+	if (mctx->keylen && !S->buflen) {
+		memcpy(out, mctx->empty, S->outlen);
+		return 0;
+	}
+	ret = blake2b_final_arch(S, out, S->outlen);
 	if (ret)
 		return -EINVAL;
 	return 0;
 }
 
+static int chksum_final(struct shash_desc *desc, u8 *out)
+{
+	struct chksum_desc_ctx *ctx = shash_desc_ctx(desc);
+
+	return blake2b_ctx_final(crypto_shash_ctx(desc->tfm), ctx->S, out);
+}
+
 static int chksum_finup(struct shash_desc *desc, const u8 *data,
 			unsigned int len, u8 *out)
 {
 	struct chksum_desc_ctx *ctx = shash_desc_ctx(desc);
 	int ret;
 
-	ret = blake2b_update(ctx->S, data, len);
+	/* The keyed empty message is handled by final */
+	if (!len)
+		return chksum_final(desc, out);
+
+	ret = blake2b_finup_arch(ctx->S, data, len, out);
 	if (ret)
 		return -EINVAL;
-	ret = blake2b_final(ctx->S, out, BLAKE2B_OUTBYTES);
+	return 0;
+}
+
+static int chksum_digest(struct shash_desc *desc, const u8 *data,
+			 unsigned int len, u8 *out)
+{
+	int ret;
+
+	ret = chksum_init(desc);
 	if (ret)
+		return ret;
+	return chksum_finup(desc, data, len, out);
+}
+
+/*
+ * The finalization flags are only set by final, an exported state is the
+ * chaining value, counter and the buffered tail. f[] and last_node are not
+ * part of it, only a state before final can be exported, not a finalized
+ * one or a tree node with last_node set.
+ */
+struct chksum_export_state {
+	u64 h[8];
+	u64 t[2];
+	u8 buf[BLAKE2B_BLOCKBYTES];
+	u8 buflen;
+	u8 outlen;
+};
+
+static void blake2b_export_state(const struct blake2b_state *S, void *out)
+{
+	struct chksum_export_state *state = out;
+
+	memcpy(state->h, S->h, sizeof(state->h));
+	memcpy(state->t, S->t, sizeof(state->t));
+	memcpy(state->buf, S->buf, S->buflen);
+	/* The rest of the block is stale input, do not leak it */
+	memset(state->buf + S->buflen, 0, BLAKE2B_BLOCKBYTES - S->buflen);
+	state->buflen = S->buflen;
+	state->outlen = S->outlen;
+}
+
+static int blake2b_import_state(struct blake2b_state *S, const void *in,
+				unsigned int digestsize)
+{
+	const struct chksum_export_state *state = in;
+
+	if (state->buflen > BLAKE2B_BLOCKBYTES || state->outlen != digestsize)
 		return -EINVAL;
 
+	memset(S, 0, sizeof(*S));
+	memcpy(S->h, state->h, sizeof(state->h));
+	memcpy(S->t, state->t, sizeof(state->t));
+	memcpy(S->buf, state->buf, state->buflen);
+	S->buflen = state->buflen;
+	S->outlen = state->outlen;
 	return 0;
 }
 
-static int blake2b_cra_init(struct crypto_tfm *tfm)
+static int chksum_export(struct shash_desc *desc, void *out)
 {
-	struct chksum_ctx *mctx = crypto_tfm_ctx(tfm);
-	int i;
+	struct chksum_desc_ctx *ctx = shash_desc_ctx(desc);
 
-	for (i = 0; i <BLAKE2B_KEYBYTES; i++)
-		mctx->key[i] = (u8)i;
+	blake2b_export_state(ctx->S, out);
+	return 0;
+}
 
+static int chksum_import(struct shash_desc *desc, const void *in)
+{
+	struct chksum_desc_ctx *ctx = shash_desc_ctx(desc);
+
+	return blake2b_import_state(ctx->S, in,
+				    crypto_shash_digestsize(desc->tfm));
+}
+
+/* The keyed midstate is plain data, a clone shares it without a setkey */
+static int chksum_clone_tfm(struct crypto_shash *dst, struct crypto_shash *src)
+{
+	memcpy(crypto_shash_ctx(dst), crypto_shash_ctx(src),
+	       sizeof(struct chksum_ctx));
 	return 0;
 }
 
-static struct shash_alg alg = {
-	.digestsize	=	BLAKE2B_OUTBYTES,
-	.setkey		=	chksum_setkey,
-	.init		=	chksum_init,
-	.update		=	chksum_update,
-	.final		=	chksum_final,
-	.finup		=	chksum_finup,
-	.descsize	=	sizeof(struct chksum_desc_ctx),
-	.base		=	{
-		.cra_name		=	"blake2b",
-		.cra_driver_name	=	"blake2b-generic",
-		.cra_priority		=	100,
-		.cra_flags		=	CRYPTO_ALG_OPTIONAL_KEY,
-		.cra_blocksize		=	1,
-		.cra_ctxsize		=	sizeof(struct chksum_ctx),
-		.cra_module		=	THIS_MODULE,
-		.cra_init		=	blake2b_cra_init,
+/* Unkeyed hashing until a key is set */
+static int chksum_init_tfm(struct crypto_shash *tfm)
+{
+	struct chksum_ctx *mctx = crypto_shash_ctx(tfm);
+
+	mctx->keylen = 0;
+	if (blake2b_init(mctx->S, crypto_shash_digestsize(tfm)))
+		return -EINVAL;
+	return 0;
+}
+
+#define BLAKE2B_ALG(name, driver_name, digest_size)			\
+	{								\
+		.digestsize	=	digest_size,			\
+		.setkey		=	chksum_setkey,			\
+		.init		=	chksum_init,			\
+		.update		=	chksum_update,			\
+		.final		=	chksum_final,			\
+		.finup		=	chksum_finup,			\
+		.digest		=	chksum_digest,			\
+		.export		=	chksum_export,			\
+		.import		=	chksum_import,			\
+		.clone_tfm	=	chksum_clone_tfm,		\
+		.init_tfm	=	chksum_init_tfm,		\
+		.descsize	=	sizeof(struct chksum_desc_ctx),	\
+		.statesize	=	sizeof(struct chksum_export_state), \
+		.base		=	{				\
+			.cra_name		=	name,		\
+			.cra_driver_name	=	driver_name,	\
+			.cra_priority		=	100,		\
+			.cra_flags		=	CRYPTO_ALG_OPTIONAL_KEY, \
+			.cra_blocksize		=	1,		\
+			.cra_ctxsize		=	sizeof(struct chksum_ctx), \
+			.cra_module		=	THIS_MODULE,	\
+		}							\
 	}
+
+/* The full length digest and the truncated variants, 160/256/384 bits */
+static struct shash_alg algs[] = {
+	BLAKE2B_ALG("blake2b", "blake2b-generic", BLAKE2B_OUTBYTES),
+	BLAKE2B_ALG("blake2b-160", "blake2b-160-generic", 20),
+	BLAKE2B_ALG("blake2b-256", "blake2b-256-generic", 32),
+	BLAKE2B_ALG("blake2b-384", "blake2b-384-generic", 48),
 };
 
+#include "blake2bp.c"
+#include "blake2xb.c"
+#include "blake2b-selftest.c"
+
 static int __init blake2b_mod_init(void)
 {
-	return crypto_register_shash(&alg);
+	int ret;
+
+	ret = blake2b_arch_init(algs, ARRAY_SIZE(algs));
+	if (ret)
+		return ret;
+
+	ret = blake2b_selftest();
+	if (ret)
+		goto out_arch;
+
+	ret = crypto_register_shashes(algs, ARRAY_SIZE(algs));
+	if (ret)
+		goto out_arch;
+
+	ret = crypto_register_ahash(&blake2bp_alg);
+	if (ret)
+		goto out_shashes;
+	return 0;
+
+out_shashes:
+	crypto_unregister_shashes(algs, ARRAY_SIZE(algs));
+out_arch:
+	blake2b_arch_exit();
+	return ret;
 }
 
 static void __exit blake2b_mod_fini(void)
 {
-	crypto_unregister_shash(&alg);
+	crypto_unregister_ahash(&blake2bp_alg);
+	crypto_unregister_shashes(algs, ARRAY_SIZE(algs));
+	blake2b_arch_exit();
 }
 
 subsys_initcall(blake2b_mod_init);
 module_exit(blake2b_mod_fini);
 
 MODULE_AUTHOR("kdave@kernel.org");
-MODULE_DESCRIPTION("BLAKE2b reference implementation");
 MODULE_LICENSE("GPL");
 MODULE_ALIAS_CRYPTO("blake2b");
+MODULE_ALIAS_CRYPTO("blake2b-160");
+MODULE_ALIAS_CRYPTO("blake2b-256");
+MODULE_ALIAS_CRYPTO("blake2b-384");
+MODULE_ALIAS_CRYPTO("blake2bp");
+#ifndef BLAKE2B_SIMD
+MODULE_DESCRIPTION("BLAKE2b reference implementation");
 MODULE_ALIAS_CRYPTO("blake2b-generic");
+MODULE_ALIAS_CRYPTO("blake2b-160-generic");
+MODULE_ALIAS_CRYPTO("blake2b-256-generic");
+MODULE_ALIAS_CRYPTO("blake2b-384-generic");
+MODULE_ALIAS_CRYPTO("blake2bp-generic");
+#endif
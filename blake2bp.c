@@ -0,0 +1,309 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * BLAKE2bp, 4 BLAKE2b leaves hashing interleaved blocks and a root hashing
+ * the leaf digests, included by blake2b.c
+ *
+ * The state does not fit the shash descriptor size limit, the algorithm is
+ * registered as a synchronous ahash with the state in the request.
+ */
+
+#define BLAKE2BP_STRIPE		(BLAKE2BP_LEAVES * BLAKE2B_BLOCKBYTES)
+
+/* Block i of each stripe to leaf i, the leaves buffer their last block */
+typedef void (*blake2bp_stripes_t)(struct blake2b_state *S, const u8 *in,
+				   size_t nstripes);
+
+static void blake2bp_init_node(struct blake2b_state *S, size_t outlen,
+			       size_t keylen, u32 offset, u8 depth)
+{
+	struct blake2b_param P[1];
+
+	P->digest_length = (u8)outlen;
+	P->key_length    = (u8)keylen;
+	P->fanout        = BLAKE2BP_LEAVES;
+	P->depth         = 2;
+	store32(&P->leaf_length, 0);
+	store32(&P->node_offset, offset);
+	store32(&P->xof_length, 0);
+	P->node_depth    = depth;
+	P->inner_length  = BLAKE2B_OUTBYTES;
+	memset(P->reserved, 0, sizeof(P->reserved));
+	memset(P->salt,     0, sizeof(P->salt));
+	memset(P->personal, 0, sizeof(P->personal));
+	blake2b_init_param(S, P);
+}
+
+static int __blake2bp_init(struct blake2bp_state *S, size_t outlen,
+			   const void *key, size_t keylen)
+{
+	size_t i;
+
+	if ((!outlen) || (outlen > BLAKE2B_OUTBYTES))
+		return -1;
+
+	if (keylen > BLAKE2B_KEYBYTES)
+		return -1;
+
+	memset(S->buf, 0, sizeof(S->buf));
+	S->buflen = 0;
+	S->outlen = outlen;
+
+	blake2bp_init_node(&S->R, outlen, keylen, 0, 1);
+	S->R.last_node = 1;
+	for (i = 0; i < BLAKE2BP_LEAVES; ++i) {
+		blake2bp_init_node(&S->S[i], outlen, keylen, i, 0);
+		/* The leaves output the full inner length */
+		S->S[i].outlen = BLAKE2B_OUTBYTES;
+	}
+	S->S[BLAKE2BP_LEAVES - 1].last_node = 1;
+
+	/* Only the leaves hash the key block */
+	if (keylen) {
+		u8 block[BLAKE2B_BLOCKBYTES];
+
+		memset(block, 0, BLAKE2B_BLOCKBYTES);
+		memcpy(block, key, keylen);
+		for (i = 0; i < BLAKE2BP_LEAVES; ++i)
+			blake2b_update(&S->S[i], block, BLAKE2B_BLOCKBYTES);
+		memzero_explicit(block, BLAKE2B_BLOCKBYTES);
+	}
+	return 0;
+}
+
+int blake2bp_init(struct blake2bp_state *S, size_t outlen)
+{
+	return __blake2bp_init(S, outlen, NULL, 0);
+}
+
+int blake2bp_init_key(struct blake2bp_state *S, size_t outlen, const void *key,
+		      size_t keylen)
+{
+	if (!key || !keylen)
+		return -1;
+
+	return __blake2bp_init(S, outlen, key, keylen);
+}
+
+static void blake2bp_stripes_generic(struct blake2b_state *S, const u8 *in,
+				     size_t nstripes)
+{
+	size_t i, k;
+
+	for (i = 0; i < BLAKE2BP_LEAVES; ++i)
+		for (k = 0; k < nstripes; ++k)
+			blake2b_update(&S[i], in + k * BLAKE2BP_STRIPE +
+					      i * BLAKE2B_BLOCKBYTES,
+				       BLAKE2B_BLOCKBYTES);
+}
+
+static __always_inline int __blake2bp_update(struct blake2bp_state *S,
+					     const void *pin, size_t inlen,
+					     blake2bp_stripes_t stripes)
+{
+	const u8 *in = pin;
+	size_t left = S->buflen;
+	size_t fill = BLAKE2BP_STRIPE - left;
+	size_t nstripes;
+
+	if (left && inlen >= fill) {
+		memcpy(S->buf + left, in, fill);
+		stripes(S->S, S->buf, 1);
+		in += fill;
+		inlen -= fill;
+		left = 0;
+	}
+
+	nstripes = inlen / BLAKE2BP_STRIPE;
+	if (nstripes) {
+		stripes(S->S, in, nstripes);
+		in += nstripes * BLAKE2BP_STRIPE;
+		inlen -= nstripes * BLAKE2BP_STRIPE;
+	}
+
+	memcpy(S->buf + left, in, inlen);
+	S->buflen = left + inlen;
+	return 0;
+}
+
+/* The buffered stripe to the leaves, then the leaf digests to the root */
+static __always_inline int __blake2bp_final(struct blake2bp_state *S,
+					    void *out, size_t outlen,
+					    int (*update)(struct blake2b_state *,
+							  const void *, size_t),
+					    int (*final)(struct blake2b_state *,
+							 void *, size_t))
+{
+	u8 hash[BLAKE2BP_LEAVES][BLAKE2B_OUTBYTES];
+	size_t i;
+	int ret;
+
+	if (out == NULL || outlen < S->outlen)
+		return -1;
+
+	for (i = 0; i < BLAKE2BP_LEAVES; ++i) {
+		if (S->buflen > i * BLAKE2B_BLOCKBYTES) {
+			size_t left = min_t(size_t,
+					    S->buflen - i * BLAKE2B_BLOCKBYTES,
+					    BLAKE2B_BLOCKBYTES);
+
+			update(&S->S[i], S->buf + i * BLAKE2B_BLOCKBYTES, left);
+		}
+		final(&S->S[i], hash[i], BLAKE2B_OUTBYTES);
+	}
+
+	for (i = 0; i < BLAKE2BP_LEAVES; ++i)
+		update(&S->R, hash[i], BLAKE2B_OUTBYTES);
+
+	ret = final(&S->R, out, S->outlen);
+	memzero_explicit(hash, sizeof(hash));
+	return ret;
+}
+
+int blake2bp_update(struct blake2bp_state *S, const void *pin, size_t inlen)
+{
+	return __blake2bp_update(S, pin, inlen, blake2bp_stripes_generic);
+}
+
+int blake2bp_final(struct blake2bp_state *S, void *out, size_t outlen)
+{
+	return __blake2bp_final(S, out, outlen, blake2b_update, blake2b_final);
+}
+
+#ifdef BLAKE2B_SIMD
+/* Defined in blake2b-glue.c, the leaves run on the multi-buffer lanes */
+static int blake2bp_update_arch(struct blake2bp_state *S, const void *pin,
+				size_t inlen);
+static int blake2bp_final_arch(struct blake2bp_state *S, void *out,
+			       size_t outlen);
+#else
+#define blake2bp_update_arch		blake2bp_update
+#define blake2bp_final_arch		blake2bp_final
+#endif
+
+/* With a key set, S holds the state after the key blocks so init is a copy */
+struct blake2bp_ctx {
+	struct blake2bp_state S[1];
+	unsigned int keylen;
+};
+
+struct blake2bp_reqctx {
+	struct blake2bp_state S[1];
+};
+
+static int blake2bp_init_req(struct ahash_request *req)
+{
+	struct crypto_ahash *tfm = crypto_ahash_reqtfm(req);
+	struct blake2bp_ctx *mctx = crypto_ahash_ctx(tfm);
+	struct blake2bp_reqctx *rctx = ahash_request_ctx(req);
+
+	/* Unkeyed hashing until a key is set */
+	if (mctx->keylen) {
+		*rctx->S = *mctx->S;
+		return 0;
+	}
+	if (blake2bp_init(rctx->S, crypto_ahash_digestsize(tfm)))
+		return -EINVAL;
+	return 0;
+}
+
+static int blake2bp_setkey(struct crypto_ahash *tfm, const u8 *key,
+			   unsigned int keylen)
+{
+	struct blake2bp_ctx *mctx = crypto_ahash_ctx(tfm);
+
+	if (!keylen || keylen > BLAKE2B_KEYBYTES)
+		return -EINVAL;
+	if (blake2bp_init_key(mctx->S, crypto_ahash_digestsize(tfm), key,
+			      keylen))
+		return -EINVAL;
+
+	mctx->keylen = keylen;
+	return 0;
+}
+
+static int blake2bp_update_req(struct ahash_request *req)
+{
+	struct blake2bp_reqctx *rctx = ahash_request_ctx(req);
+	struct crypto_hash_walk walk;
+	int nbytes;
+
+	for (nbytes = crypto_hash_walk_first(req, &walk); nbytes > 0;
+	     nbytes = crypto_hash_walk_done(&walk, 0))
+		blake2bp_update_arch(rctx->S, walk.data, nbytes);
+
+	return nbytes;
+}
+
+static int blake2bp_final_req(struct ahash_request *req)
+{
+	struct blake2bp_reqctx *rctx = ahash_request_ctx(req);
+	int ret;
+
+	ret = blake2bp_final_arch(rctx->S, req->result, rctx->S->outlen);
+	memzero_explicit(rctx->S, sizeof(rctx->S));
+	if (ret)
+		return -EINVAL;
+	return 0;
+}
+
+static int blake2bp_finup_req(struct ahash_request *req)
+{
+	int ret;
+
+	ret = blake2bp_update_req(req);
+	if (ret)
+		return ret;
+	return blake2bp_final_req(req);
+}
+
+static int blake2bp_digest_req(struct ahash_request *req)
+{
+	int ret;
+
+	ret = blake2bp_init_req(req);
+	if (ret)
+		return ret;
+	return blake2bp_finup_req(req);
+}
+
+static int blake2bp_init_tfm(struct crypto_ahash *tfm)
+{
+	struct blake2bp_ctx *mctx = crypto_ahash_ctx(tfm);
+
+	mctx->keylen = 0;
+	crypto_ahash_set_reqsize(tfm, sizeof(struct blake2bp_reqctx));
+	return 0;
+}
+
+/* The keyed state is plain data, a clone shares it without a setkey */
+static int blake2bp_clone_tfm(struct crypto_ahash *dst,
+			      struct crypto_ahash *src)
+{
+	memcpy(crypto_ahash_ctx(dst), crypto_ahash_ctx(src),
+	       sizeof(struct blake2bp_ctx));
+	return 0;
+}
+
+/* No export and import, the state is larger than HASH_MAX_STATESIZE */
+static struct ahash_alg blake2bp_alg = {
+	.init		=	blake2bp_init_req,
+	.update		=	blake2bp_update_req,
+	.final		=	blake2bp_final_req,
+	.finup		=	blake2bp_finup_req,
+	.digest		=	blake2bp_digest_req,
+	.setkey		=	blake2bp_setkey,
+	.init_tfm	=	blake2bp_init_tfm,
+	.clone_tfm	=	blake2bp_clone_tfm,
+	.halg		=	{
+		.digestsize	=	BLAKE2B_OUTBYTES,
+		.base		=	{
+			.cra_name		=	"blake2bp",
+			.cra_driver_name	=	"blake2bp-generic",
+			.cra_priority		=	100,
+			.cra_flags		=	CRYPTO_ALG_OPTIONAL_KEY,
+			.cra_blocksize		=	1,
+			.cra_ctxsize		=	sizeof(struct blake2bp_ctx),
+			.cra_module		=	THIS_MODULE,
+		}
+	}
+};
@@ -0,0 +1,273 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * BLAKE2s shash driver using the generated SSSE3, AVX and AVX-512VL compress
+ * functions
+ *
+ * The backend is picked by CPU features at load time, the generic compress
+ * is used when the FPU is not usable.
+ */
+
+#include <asm/cpufeature.h>
+#include <asm/fpu/api.h>
+#include <linux/jump_label.h>
+#include <linux/sizes.h>
+#include <linux/slab.h>
+#include <linux/static_call.h>
+
+#define BLAKE2S_SIMD
+
+#include "blake2s.c"
+
+/* Limit the time spent with preemption disabled */
+#define BLAKE2S_FPU_CHUNK	SZ_4K
+
+/* The chaining value stays in registers for all nblocks */
+asmlinkage void blake2s_compress_blocks_ssse3(struct blake2s_state *S,
+					      const u8 *block, size_t nblocks,
+					      u32 inc);
+asmlinkage void blake2s_compress_blocks_avx(struct blake2s_state *S,
+					    const u8 *block, size_t nblocks,
+					    u32 inc);
+asmlinkage void blake2s_compress_blocks_avx512vl(struct blake2s_state *S,
+						 const u8 *block, size_t nblocks,
+						 u32 inc);
+
+/* Multi-buffer batch API in blake2s-mb.c */
+void blake2s_mb_init(void);
+unsigned int blake2s_mb_nr_lanes(void);
+void blake2s_mb_update_stripes(struct blake2s_state *S, unsigned int count,
+			       const u8 *in, size_t nstripes);
+void blake2s_mb_xof_blocks(const struct blake2s_state *C, const u8 *root,
+			   u32 first, size_t nblocks, u8 *out);
+unsigned int blake2s_mb_sectors(const struct blake2s_state *init,
+				const u8 *base, size_t sector_size,
+				unsigned int count, u8 *out, const u8 *sums,
+				unsigned long *mismatch, size_t outlen);
+
+/* vprord on xmm registers only, no zmm frequency penalty */
+static bool blake2s_avx512vl_usable(void)
+{
+	return boot_cpu_has(X86_FEATURE_AVX) &&
+	       boot_cpu_has(X86_FEATURE_AVX512F) &&
+	       boot_cpu_has(X86_FEATURE_AVX512VL) &&
+	       cpu_has_xfeatures(XFEATURE_MASK_SSE | XFEATURE_MASK_YMM |
+				 XFEATURE_MASK_AVX512, NULL);
+}
+
+static bool blake2s_avx_usable(void)
+{
+	return boot_cpu_has(X86_FEATURE_AVX) &&
+	       cpu_has_xfeatures(XFEATURE_MASK_SSE | XFEATURE_MASK_YMM, NULL);
+}
+
+static bool blake2s_ssse3_usable(void)
+{
+	return boot_cpu_has(X86_FEATURE_SSSE3);
+}
+
+struct blake2s_backend {
+	const char *name;
+	const char *driver_suffix;
+	int priority;
+	blake2s_compress_t compress;
+	bool (*usable)(void);
+};
+
+/* In order of preference */
+static const struct blake2s_backend blake2s_backends[] = {
+	{ "avx512vl", "avx512vl", 400, blake2s_compress_blocks_avx512vl,
+	  blake2s_avx512vl_usable },
+	{ "avx", "avx", 300, blake2s_compress_blocks_avx,
+	  blake2s_avx_usable },
+	{ "ssse3", "ssse3", 200, blake2s_compress_blocks_ssse3,
+	  blake2s_ssse3_usable },
+	{ "generic", "x86_64-generic", 100, blake2s_compress_generic,
+	  NULL },
+};
+
+DEFINE_STATIC_CALL(blake2s_compress_simd, blake2s_compress_blocks_ssse3);
+static DEFINE_STATIC_KEY_FALSE(blake2s_use_simd);
+
+static char *backend;
+module_param(backend, charp, 0444);
+MODULE_PARM_DESC(backend, "Force the compress backend: avx512vl, avx, ssse3 or generic");
+
+static __always_inline void blake2s_compress_arch(struct blake2s_state *S,
+						  const u8 *block,
+						  size_t nblocks, u32 inc)
+{
+	static_call(blake2s_compress_simd)(S, block, nblocks, inc);
+}
+
+static int blake2s_update_arch(struct blake2s_state *S, const void *pin,
+			       size_t inlen)
+{
+	const u8 *in = pin;
+
+	if (!static_branch_likely(&blake2s_use_simd) || !irq_fpu_usable())
+		return blake2s_update(S, pin, inlen);
+
+	while (inlen > 0) {
+		size_t chunk = min_t(size_t, inlen, BLAKE2S_FPU_CHUNK);
+
+		kernel_fpu_begin();
+		__blake2s_update(S, in, chunk, blake2s_compress_arch);
+		kernel_fpu_end();
+		in += chunk;
+		inlen -= chunk;
+	}
+	return 0;
+}
+
+static int blake2s_final_arch(struct blake2s_state *S, void *out, size_t outlen)
+{
+	int ret;
+
+	if (!static_branch_likely(&blake2s_use_simd) || !irq_fpu_usable())
+		return blake2s_final(S, out, outlen);
+
+	kernel_fpu_begin();
+	ret = __blake2s_final(S, out, outlen, blake2s_compress_arch);
+	kernel_fpu_end();
+	return ret;
+}
+
+/* All but the last FPU chunk go through update, the tail is one-shot */
+static int blake2s_finup_arch(struct blake2s_state *S, const u8 *in,
+			      size_t inlen, u8 *out)
+{
+	int ret;
+
+	if (!static_branch_likely(&blake2s_use_simd) || !irq_fpu_usable())
+		return blake2s_finup(S, in, inlen, out);
+
+	if (inlen > BLAKE2S_FPU_CHUNK) {
+		size_t head = round_down(inlen - 1, BLAKE2S_FPU_CHUNK);
+
+		blake2s_update_arch(S, in, head);
+		in += head;
+		inlen -= head;
+	}
+
+	kernel_fpu_begin();
+	ret = __blake2s_finup(S, in, inlen, out, blake2s_compress_arch);
+	kernel_fpu_end();
+	return ret;
+}
+
+/* BLAKE2sp leaves on the multi-buffer lanes, the finalization is serial */
+static void blake2sp_stripes_arch(struct blake2s_state *S, const u8 *in,
+				  size_t nstripes)
+{
+	if (!blake2s_mb_nr_lanes() || !irq_fpu_usable())
+		return blake2sp_stripes_generic(S, in, nstripes);
+
+	blake2s_mb_update_stripes(S, BLAKE2SP_LEAVES, in, nstripes);
+}
+
+static int blake2sp_update_arch(struct blake2sp_state *S, const void *pin,
+				size_t inlen)
+{
+	return __blake2sp_update(S, pin, inlen, blake2sp_stripes_arch);
+}
+
+static int blake2sp_final_arch(struct blake2sp_state *S, void *out,
+			       size_t outlen)
+{
+	return __blake2sp_final(S, out, outlen, blake2s_update_arch,
+				blake2s_final_arch);
+}
+
+/* BLAKE2Xs output blocks on the multi-buffer lanes */
+static void blake2xs_blocks_arch(const struct blake2s_state *C,
+				 const u8 *root, u32 first, size_t nblocks,
+				 u8 *out)
+{
+	if (nblocks < 2 || !blake2s_mb_nr_lanes() || !irq_fpu_usable())
+		return __blake2xs_blocks(C, root, first, nblocks, out,
+					  blake2s_update_arch,
+					  blake2s_final_arch);
+
+	blake2s_mb_xof_blocks(C, root, first, nblocks, out);
+}
+
+#include "blake2s-sg-ahash.c"
+#include "blake2s-verity.c"
+
+static int __init blake2s_arch_init(struct shash_alg *algs, int count)
+{
+	const struct blake2s_backend *b;
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(blake2s_backends); i++) {
+		b = &blake2s_backends[i];
+		if (backend && strcmp(backend, b->name))
+			continue;
+		if (b->usable && !b->usable()) {
+			if (backend) {
+				pr_err("blake2s: backend %s not supported by the CPU\n",
+				       backend);
+				return -ENODEV;
+			}
+			continue;
+		}
+		break;
+	}
+	if (i == ARRAY_SIZE(blake2s_backends)) {
+		pr_err("blake2s: unknown backend %s\n", backend);
+		return -EINVAL;
+	}
+
+	if (b->compress != blake2s_compress_generic) {
+		static_call_update(blake2s_compress_simd, b->compress);
+		static_branch_enable(&blake2s_use_simd);
+	}
+	pr_info("blake2s: using %s\n", b->name);
+	blake2s_mb_init();
+
+	for (i = 0; i < count; i++) {
+		snprintf(algs[i].base.cra_driver_name, CRYPTO_MAX_ALG_NAME,
+			 "%s-%s", algs[i].base.cra_name, b->driver_suffix);
+		algs[i].base.cra_priority = b->priority;
+	}
+
+	/* BLAKE2sp is named after the multi-buffer kernel of its leaves */
+	if (blake2s_mb_nr_lanes())
+		blake2sp_alg.halg.base.cra_priority = 300;
+	snprintf(blake2sp_alg.halg.base.cra_driver_name, CRYPTO_MAX_ALG_NAME,
+		 "blake2sp-%s", blake2s_mb_nr_lanes() == 16 ? "avx512" :
+				blake2s_mb_nr_lanes() == 8 ? "avx2" :
+				"x86_64-generic");
+
+	return blake2s_sg_register(b);
+}
+
+static void blake2s_arch_exit(void)
+{
+	blake2s_sg_unregister();
+}
+
+MODULE_DESCRIPTION("BLAKE2s SIMD implementation");
+MODULE_ALIAS_CRYPTO("blake2s-avx512vl");
+MODULE_ALIAS_CRYPTO("blake2s-sg-avx512vl");
+MODULE_ALIAS_CRYPTO("blake2s-sg-avx");
+MODULE_ALIAS_CRYPTO("blake2s-sg-ssse3");
+MODULE_ALIAS_CRYPTO("blake2s-sg-x86_64-generic");
+MODULE_ALIAS_CRYPTO("blake2sp-avx512");
+MODULE_ALIAS_CRYPTO("blake2sp-avx2");
+MODULE_ALIAS_CRYPTO("blake2sp-x86_64-generic");
+MODULE_ALIAS_CRYPTO("blake2s-avx");
+MODULE_ALIAS_CRYPTO("blake2s-ssse3");
+MODULE_ALIAS_CRYPTO("blake2s-x86_64-generic");
+MODULE_ALIAS_CRYPTO("blake2s-128-avx512vl");
+MODULE_ALIAS_CRYPTO("blake2s-128-avx");
+MODULE_ALIAS_CRYPTO("blake2s-128-ssse3");
+MODULE_ALIAS_CRYPTO("blake2s-128-x86_64-generic");
+MODULE_ALIAS_CRYPTO("blake2s-160-avx512vl");
+MODULE_ALIAS_CRYPTO("blake2s-160-avx");
+MODULE_ALIAS_CRYPTO("blake2s-160-ssse3");
+MODULE_ALIAS_CRYPTO("blake2s-160-x86_64-generic");
+MODULE_ALIAS_CRYPTO("blake2s-224-avx512vl");
+MODULE_ALIAS_CRYPTO("blake2s-224-avx");
+MODULE_ALIAS_CRYPTO("blake2s-224-ssse3");
+MODULE_ALIAS_CRYPTO("blake2s-224-x86_64-generic");
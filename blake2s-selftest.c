@@ -0,0 +1,426 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * Known answer tests run at module init, included by blake2s.c
+ *
+ * The message is in[i] = i mod 256 and the key 00..1f. The vectors up
+ * to 255 bytes are from the reference blake2sp-kat.txt, the longer ones
+ * reach the stripe path and were made with the reference code. Each one is
+ * hashed in one piece and split in two updates, on the generic leaves and
+ * on the _arch ones.
+ *
+ * BLAKE2Xs is checked with a known, an unknown and a long output length, each
+ * through the generic output blocks and the _arch ones.
+ */
+
+#include <linux/bitmap.h>
+#include <linux/slab.h>
+
+#define BLAKE2S_SELFTEST_MAXLEN	2049
+
+static const u16 blake2sp_kat_len[] __initconst = {
+	0, 1, 63, 64, 65, 255, 511, 512, 1023, 2049
+};
+
+static const u8 blake2sp_kat[][BLAKE2S_OUTBYTES] __initconst = {
+	{ 0x71, 0x5c, 0xb1, 0x38, 0x95, 0xae, 0xb6, 0x78,
+	  0xf6, 0x12, 0x41, 0x60, 0xbf, 0xf2, 0x14, 0x65,
+	  0xb3, 0x0f, 0x4f, 0x68, 0x74, 0x19, 0x3f, 0xc8,
+	  0x51, 0xb4, 0x62, 0x10, 0x43, 0xf0, 0x9c, 0xc6 },
+	{ 0x40, 0x57, 0x8f, 0xfa, 0x52, 0xbf, 0x51, 0xae,
+	  0x18, 0x66, 0xf4, 0x28, 0x4d, 0x3a, 0x15, 0x7f,
+	  0xc1, 0xbc, 0xd3, 0x6a, 0xc1, 0x3c, 0xbd, 0xcb,
+	  0x03, 0x77, 0xe4, 0xd0, 0xcd, 0x0b, 0x66, 0x03 },
+	{ 0xe8, 0x55, 0x94, 0x70, 0x0e, 0x39, 0x22, 0xa1,
+	  0xe8, 0xe4, 0x1e, 0xb8, 0xb0, 0x64, 0xe7, 0xac,
+	  0x6d, 0x94, 0x9d, 0x13, 0xb5, 0xa3, 0x45, 0x23,
+	  0xe5, 0xa6, 0xbe, 0xac, 0x03, 0xc8, 0xab, 0x29 },
+	{ 0x1d, 0x37, 0x01, 0xa5, 0x66, 0x1b, 0xd3, 0x1a,
+	  0xb2, 0x05, 0x62, 0xbd, 0x07, 0xb7, 0x4d, 0xd1,
+	  0x9a, 0xc8, 0xf3, 0x52, 0x4b, 0x73, 0xce, 0x7b,
+	  0xc9, 0x96, 0xb7, 0x88, 0xaf, 0xd2, 0xf3, 0x17 },
+	{ 0x87, 0x4e, 0x19, 0x38, 0x03, 0x3d, 0x7d, 0x38,
+	  0x35, 0x97, 0xa2, 0xa6, 0x5f, 0x58, 0xb5, 0x54,
+	  0xe4, 0x11, 0x06, 0xf6, 0xd1, 0xd5, 0x0e, 0x9b,
+	  0xa0, 0xeb, 0x68, 0x5f, 0x6b, 0x6d, 0xa0, 0x71 },
+	{ 0x0c, 0x8a, 0x36, 0x59, 0x7d, 0x74, 0x61, 0xc6,
+	  0x3a, 0x94, 0x73, 0x28, 0x21, 0xc9, 0x41, 0x85,
+	  0x6c, 0x66, 0x83, 0x76, 0x60, 0x6c, 0x86, 0xa5,
+	  0x2d, 0xe0, 0xee, 0x41, 0x04, 0xc6, 0x15, 0xdb },
+	{ 0x3e, 0x39, 0x48, 0xf0, 0xb6, 0x60, 0x23, 0x48,
+	  0xb6, 0x99, 0xda, 0xb0, 0xea, 0x15, 0xc0, 0x78,
+	  0x1f, 0xd6, 0x94, 0x18, 0x35, 0x31, 0x14, 0x2f,
+	  0xb5, 0xbc, 0x88, 0x47, 0x7c, 0xac, 0xbe, 0x76 },
+	{ 0x32, 0x46, 0xbc, 0x18, 0xb4, 0x22, 0x53, 0xf5,
+	  0x8d, 0x3b, 0xc2, 0x1d, 0xd5, 0x1c, 0x14, 0x29,
+	  0x0c, 0x0b, 0x78, 0xd4, 0xd9, 0xd5, 0x27, 0x40,
+	  0x87, 0xbf, 0xf2, 0xca, 0x29, 0x7c, 0x51, 0xfc },
+	{ 0x3f, 0xe4, 0x62, 0xaa, 0xcf, 0x52, 0x58, 0x7c,
+	  0xa8, 0xae, 0x0b, 0xaa, 0x0d, 0x65, 0x57, 0x1a,
+	  0x96, 0x72, 0xca, 0xab, 0xab, 0x05, 0xfb, 0x90,
+	  0xdd, 0x11, 0xb1, 0x8f, 0xc1, 0xde, 0x2d, 0x0a },
+	{ 0xd3, 0xa1, 0xab, 0x2f, 0x4a, 0x46, 0x79, 0x8a,
+	  0xa1, 0x15, 0x3a, 0x33, 0x17, 0xa1, 0x49, 0x46,
+	  0xc9, 0xee, 0x2e, 0x7a, 0x5e, 0xf8, 0x1e, 0x40,
+	  0x47, 0xcb, 0x65, 0x76, 0x64, 0x07, 0x50, 0x39 },
+};
+
+#define BLAKE2XS_SELFTEST_INLEN		256
+#define BLAKE2XS_SELFTEST_UNKNOWN	200
+#define BLAKE2XS_SELFTEST_LONG		(33 * BLAKE2S_OUTBYTES + 9)
+
+/* Keyed BLAKE2Xs of the first 256 bytes, from the reference blake2xs-kat.txt */
+static const u16 blake2xs_kat_len[] __initconst = {
+	1, 32, 33, 65, 256
+};
+
+static const u8 blake2xs_kat[] __initconst = {
+	0x0e,
+	0xa4, 0xfe, 0x2b, 0xd0, 0xf9, 0x6a, 0x21, 0x5f,
+	0xa7, 0x16, 0x4a, 0xe1, 0xa4, 0x05, 0xf4, 0x03,
+	0x0a, 0x58, 0x6c, 0x12, 0xb0, 0xc2, 0x98, 0x06,
+	0xa0, 0x99, 0xd7, 0xd7, 0xfd, 0xd8, 0xdd, 0x72,
+	0x7d, 0xce, 0x71, 0x0a, 0x20, 0xf4, 0x2a, 0xb6,
+	0x87, 0xec, 0x6e, 0xa8, 0x3b, 0x53, 0xfa, 0xaa,
+	0x41, 0x82, 0x29, 0xce, 0x0d, 0x5a, 0x2f, 0xf2,
+	0xa5, 0xe6, 0x6d, 0xef, 0xb0, 0xb6, 0x5c, 0x03,
+	0xc9,
+	0xcf, 0x60, 0x17, 0x53, 0xff, 0xa0, 0x9f, 0xe4,
+	0x8a, 0x8a, 0x84, 0xc3, 0x77, 0x69, 0x99, 0x1e,
+	0x96, 0x29, 0x0e, 0x20, 0x0b, 0xba, 0xf1, 0x91,
+	0x0c, 0x57, 0x76, 0x0f, 0x98, 0x9b, 0xd0, 0xc7,
+	0x2e, 0x61, 0x28, 0xe2, 0x94, 0x52, 0x8e, 0xe8,
+	0x61, 0xad, 0x7e, 0xee, 0x70, 0xd5, 0x89, 0xde,
+	0x3c, 0xf4, 0xa0, 0xc3, 0x5f, 0x71, 0x97, 0xe1,
+	0x92, 0x5a, 0x64, 0xd0, 0x13, 0x36, 0x28, 0xd8,
+	0x7d,
+	0x57, 0x84, 0xe6, 0x14, 0xd5, 0x38, 0xf7, 0xf2,
+	0x6c, 0x80, 0x31, 0x91, 0xde, 0xb4, 0x64, 0xa8,
+	0x84, 0x81, 0x70, 0x02, 0x98, 0x8c, 0x36, 0x44,
+	0x8d, 0xcb, 0xec, 0xfa, 0xd1, 0x99, 0x7f, 0xe5,
+	0x1a, 0xb0, 0xb3, 0x85, 0x3c, 0x51, 0xed, 0x49,
+	0xce, 0x9f, 0x4e, 0x47, 0x75, 0x22, 0xfb, 0x3f,
+	0x32, 0xcc, 0x50, 0x51, 0x5b, 0x75, 0x3c, 0x18,
+	0xfb, 0x89, 0xa8, 0xd9, 0x65, 0xaf, 0xcf, 0x1e,
+	0xd5, 0xe0, 0x99, 0xb2, 0x2c, 0x42, 0x25, 0x73,
+	0x2b, 0xae, 0xb9, 0x86, 0xf5, 0xc5, 0xbc, 0x88,
+	0xe4, 0x58, 0x2d, 0x27, 0x91, 0x5e, 0x2a, 0x19,
+	0x12, 0x6d, 0x3d, 0x45, 0x55, 0xfa, 0xb4, 0xf6,
+	0x51, 0x6a, 0x6a, 0x15, 0x6d, 0xbf, 0xee, 0xd9,
+	0xe9, 0x82, 0xfc, 0x58, 0x9e, 0x33, 0xce, 0x2b,
+	0x9e, 0x1b, 0xa2, 0xb4, 0x16, 0xe1, 0x18, 0x52,
+	0xdd, 0xea, 0xb9, 0x30, 0x25, 0x97, 0x42, 0x67,
+	0xac, 0x82, 0xc8, 0x4f, 0x07, 0x1c, 0x3d, 0x07,
+	0xf2, 0x15, 0xf4, 0x7e, 0x35, 0x65, 0xfd, 0x1d,
+	0x96, 0x2c, 0x76, 0xe0, 0xd6, 0x35, 0x89, 0x2e,
+	0xa7, 0x14, 0x88, 0x27, 0x37, 0x65, 0x88, 0x7d,
+	0x31, 0xf2, 0x50, 0xa2, 0x6c, 0x4d, 0xdc, 0x37,
+	0x7e, 0xd8, 0x9b, 0x17, 0x32, 0x6e, 0x25, 0x9f,
+	0x6c, 0xc1, 0xde, 0x0e, 0x63, 0x15, 0x8e, 0x83,
+	0xae, 0xbb, 0x7f, 0x5a, 0x7c, 0x08, 0xc6, 0x3c,
+	0x76, 0x78, 0x76, 0xc8, 0x20, 0x36, 0x39, 0x95,
+	0x8a, 0x40, 0x7a, 0xcc, 0xa0, 0x96, 0xd1, 0xf6,
+	0x06, 0xc0, 0x4b, 0x4f, 0x4b, 0x3f, 0xd7, 0x71,
+	0x78, 0x1a, 0x59, 0x01, 0xb1, 0xc3, 0xce, 0xe7,
+	0xc0, 0x4c, 0x3b, 0x68, 0x70, 0x22, 0x6e, 0xee,
+	0x30, 0x9b, 0x74, 0xf5, 0x1e, 0xdb, 0xf7, 0x0a,
+	0x38, 0x17, 0xcc, 0x8d, 0xa8, 0x78, 0x75, 0x30,
+	0x1e, 0x04, 0xd0, 0x41, 0x6a, 0x65, 0xdc, 0x5d,
+};
+
+/* The same with an unknown output length, made with the reference code */
+static const u8 blake2xs_kat_unknown[BLAKE2XS_SELFTEST_UNKNOWN] __initconst = {
+	0x2a, 0x9a, 0x69, 0x77, 0xd9, 0x15, 0xa2, 0xc4,
+	0xdd, 0x07, 0xdb, 0xca, 0xfe, 0x19, 0x18, 0xbf,
+	0x16, 0x82, 0xe5, 0x6d, 0x9c, 0x8e, 0x56, 0x7e,
+	0xcd, 0x19, 0xbf, 0xd7, 0xcd, 0x93, 0x52, 0x88,
+	0x33, 0xc7, 0x64, 0xd1, 0x2b, 0x34, 0xa5, 0xe2,
+	0xa2, 0x19, 0xc9, 0xfd, 0x46, 0x3d, 0xab, 0x45,
+	0xe9, 0x72, 0xc5, 0x57, 0x4d, 0x73, 0xf4, 0x5d,
+	0xe5, 0xb2, 0xe2, 0x3a, 0xf7, 0x25, 0x30, 0xd8,
+	0xe0, 0xcb, 0xe4, 0x17, 0xcf, 0x12, 0x6d, 0xba,
+	0x7c, 0x59, 0x0e, 0xa8, 0xb8, 0xbc, 0xdb, 0x6e,
+	0xda, 0x48, 0xd5, 0x86, 0x65, 0xc2, 0xf8, 0x9e,
+	0x13, 0x5b, 0xa2, 0x4e, 0xf1, 0x3d, 0xb6, 0x9a,
+	0x43, 0x49, 0xed, 0x78, 0x32, 0x87, 0xec, 0xeb,
+	0x6a, 0xde, 0xed, 0x8c, 0x10, 0x66, 0x22, 0xd8,
+	0xab, 0xac, 0x20, 0x09, 0xbb, 0xee, 0xca, 0xde,
+	0x66, 0x79, 0x2f, 0x96, 0x05, 0x78, 0x5f, 0x79,
+	0x30, 0x99, 0x1e, 0x09, 0x50, 0x4e, 0xb7, 0x59,
+	0x62, 0xdd, 0x2b, 0xf3, 0x2b, 0xe2, 0xd5, 0x7c,
+	0xe4, 0xad, 0xf3, 0x2c, 0x3b, 0xe4, 0x8d, 0x1a,
+	0xc8, 0xe5, 0xea, 0xa1, 0xa8, 0x0b, 0xe5, 0x8e,
+	0x68, 0x04, 0x6a, 0x7c, 0xcc, 0xb5, 0x26, 0x65,
+	0xf0, 0xb9, 0x11, 0x2b, 0x4a, 0x45, 0x00, 0x3f,
+	0x26, 0xec, 0x2b, 0xab, 0x8d, 0x01, 0x5b, 0xc1,
+	0xe6, 0x29, 0x37, 0x1f, 0x08, 0x6c, 0xee, 0xe3,
+	0xff, 0x25, 0x28, 0x8c, 0xd2, 0xc5, 0x22, 0xef,
+};
+
+static bool __init blake2sp_selftest_one(struct blake2sp_state *S,
+					 const u8 *key, const u8 *in,
+					 size_t len, size_t split,
+					 const u8 *want,
+					 int (*update)(struct blake2sp_state *,
+						       const void *, size_t),
+					 int (*final)(struct blake2sp_state *,
+						      void *, size_t))
+{
+	u8 out[BLAKE2S_OUTBYTES];
+
+	blake2sp_init_key(S, BLAKE2S_OUTBYTES, key, BLAKE2S_KEYBYTES);
+	update(S, in, split);
+	update(S, in + split, len - split);
+	final(S, out, BLAKE2S_OUTBYTES);
+	return !memcmp(out, want, BLAKE2S_OUTBYTES);
+}
+
+static int __init blake2sp_selftest(const u8 *key, const u8 *in)
+{
+	struct blake2sp_state *S;
+	size_t i, len;
+	int ret = 0;
+
+	S = kmalloc(sizeof(*S), GFP_KERNEL);
+	if (!S)
+		return -ENOMEM;
+
+	for (i = 0; i < ARRAY_SIZE(blake2sp_kat_len); i++) {
+		len = blake2sp_kat_len[i];
+		if (blake2sp_selftest_one(S, key, in, len, 0, blake2sp_kat[i],
+					  blake2sp_update, blake2sp_final) &&
+		    blake2sp_selftest_one(S, key, in, len, len / 3,
+					  blake2sp_kat[i], blake2sp_update,
+					  blake2sp_final) &&
+		    blake2sp_selftest_one(S, key, in, len, 0, blake2sp_kat[i],
+					  blake2sp_update_arch,
+					  blake2sp_final_arch) &&
+		    blake2sp_selftest_one(S, key, in, len, len / 3,
+					  blake2sp_kat[i],
+					  blake2sp_update_arch,
+					  blake2sp_final_arch))
+			continue;
+		pr_err("blake2sp: KAT of %zu bytes failed\n", len);
+		ret = -EINVAL;
+	}
+
+	kfree_sensitive(S);
+	return ret;
+}
+
+static void __init blake2xs_selftest_one(struct blake2xs_state *S,
+					 const u8 *key, const u8 *in,
+					 size_t xof_length, u8 *out,
+					 size_t outlen, bool arch)
+{
+	blake2xs_init_key(S, xof_length, key, BLAKE2S_KEYBYTES);
+	if (arch) {
+		blake2xs_update(S, in, BLAKE2XS_SELFTEST_INLEN);
+		blake2xs_final(S, out, outlen);
+	} else {
+		blake2s_update(S->S, in, BLAKE2XS_SELFTEST_INLEN);
+		__blake2xs_final(S, out, outlen, blake2s_final,
+				 blake2xs_blocks_generic);
+	}
+}
+
+/* out[0..len) is from the generic blocks, out[len..2 * len) from _arch */
+static int __init blake2xs_selftest(const u8 *key, const u8 *in)
+{
+	const u8 *want = blake2xs_kat;
+	struct blake2xs_state *S;
+	size_t i, len;
+	int ret = 0;
+	u8 *out;
+
+	S = kmalloc(sizeof(*S), GFP_KERNEL);
+	out = kmalloc(2 * BLAKE2XS_SELFTEST_LONG, GFP_KERNEL);
+	if (!S || !out) {
+		ret = -ENOMEM;
+		goto free;
+	}
+
+	for (i = 0; i < ARRAY_SIZE(blake2xs_kat_len); i++) {
+		len = blake2xs_kat_len[i];
+		blake2xs_selftest_one(S, key, in, len, out, len, false);
+		blake2xs_selftest_one(S, key, in, len, out + len, len, true);
+		if (memcmp(out, want, len) || memcmp(out + len, want, len)) {
+			pr_err("blake2xs: KAT of %zu bytes failed\n", len);
+			ret = -EINVAL;
+		}
+		want += len;
+	}
+
+	len = BLAKE2XS_SELFTEST_UNKNOWN;
+	blake2xs_selftest_one(S, key, in, BLAKE2XS_UNKNOWN_LENGTH, out, len,
+			      false);
+	blake2xs_selftest_one(S, key, in, BLAKE2XS_UNKNOWN_LENGTH, out + len,
+			      len, true);
+	if (memcmp(out, blake2xs_kat_unknown, len) ||
+	    memcmp(out + len, blake2xs_kat_unknown, len)) {
+		pr_err("blake2xs: KAT of unknown length failed\n");
+		ret = -EINVAL;
+	}
+
+	/* More output blocks than lanes, with a partial last one */
+	len = BLAKE2XS_SELFTEST_LONG;
+	blake2xs_selftest_one(S, key, in, len, out, len, false);
+	blake2xs_selftest_one(S, key, in, len, out + len, len, true);
+	if (memcmp(out, out + len, len)) {
+		pr_err("blake2xs: _arch output of %zu bytes differs\n", len);
+		ret = -EINVAL;
+	}
+
+free:
+	kfree(out);
+	kfree_sensitive(S);
+	return ret;
+}
+
+#ifdef BLAKE2S_SIMD
+/* More states than lanes, so the lanes are refilled */
+#define BLAKE2S_SELFTEST_MANY	(2 * BLAKE2S_MB_LANES + 3)
+
+/* State i of the update_many test, keys, salts and digest lengths all differ */
+static void __init blake2s_many_init(struct blake2s_state *S, unsigned int i,
+				     const u8 *key, const u8 *in)
+{
+	blake2s_init_salt_personal(S, 1 + i * 7 % BLAKE2S_OUTBYTES, key,
+				   i % (BLAKE2S_KEYBYTES + 1), in + i,
+				   in + 2 * i);
+}
+
+/*
+ * blake2s_update_many() in one call and in two, against separate updates of
+ * the same states
+ */
+static int __init blake2s_many_selftest(const u8 *key, const u8 *in)
+{
+	static const u16 split[] __initconst = { 0, 1, 127, 1000 };
+	struct blake2s_state *P[BLAKE2S_SELFTEST_MANY];
+	const size_t len = BLAKE2S_SELFTEST_MAXLEN;
+	u8 want[BLAKE2S_OUTBYTES];
+	u8 out[BLAKE2S_OUTBYTES];
+	struct blake2s_state *S;
+	unsigned int i, j;
+	size_t outlen;
+	int ret = 0;
+
+	/* S[i] goes through update_many, S[i + MANY] is its reference */
+	S = kmalloc_array(2 * BLAKE2S_SELFTEST_MANY, sizeof(*S), GFP_KERNEL);
+	if (!S)
+		return -ENOMEM;
+
+	for (j = 0; j < ARRAY_SIZE(split); j++) {
+		for (i = 0; i < BLAKE2S_SELFTEST_MANY; i++) {
+			blake2s_many_init(&S[i], i, key, in);
+			P[i] = &S[i];
+		}
+		blake2s_update_many(P, BLAKE2S_SELFTEST_MANY, in, split[j]);
+		blake2s_update_many(P, BLAKE2S_SELFTEST_MANY, in + split[j],
+				    len - split[j]);
+
+		for (i = 0; i < BLAKE2S_SELFTEST_MANY; i++) {
+			P[i] = &S[i + BLAKE2S_SELFTEST_MANY];
+			blake2s_many_init(P[i], i, key, in);
+			blake2s_update(P[i], in, len);
+			outlen = P[i]->outlen;
+			blake2s_final(P[i], want, sizeof(want));
+			blake2s_final(&S[i], out, sizeof(out));
+			if (memcmp(out, want, outlen)) {
+				pr_err("blake2s: update_many of state %u split at %u failed\n",
+				       i, split[j]);
+				ret = -EINVAL;
+			}
+		}
+	}
+
+	kfree_sensitive(S);
+	return ret;
+}
+
+/* Sectors of two blocks, the last one partial, more of them than lanes */
+#define BLAKE2S_SELFTEST_SECTOR		100
+#define BLAKE2S_SELFTEST_SECTORS	(BLAKE2S_MB_LANES + 3)
+
+/*
+ * digest_sectors and verify_sectors against blake2s_update() of each sector,
+ * verify gets one wrong checksum
+ */
+static int __init blake2s_sectors_selftest(const u8 *key, const u8 *in)
+{
+	const unsigned int count = BLAKE2S_SELFTEST_SECTORS;
+	const size_t size = BLAKE2S_SELFTEST_SECTOR;
+	DECLARE_BITMAP(mismatch, BLAKE2S_SELFTEST_SECTORS);
+	unsigned int nr_mismatch, i, k;
+	size_t keylen, outlen;
+	struct blake2s_state S;
+	u8 *want, *out;
+	int ret = 0;
+
+	want = kmalloc_array(2 * count, BLAKE2S_OUTBYTES, GFP_KERNEL);
+	if (!want)
+		return -ENOMEM;
+	out = want + count * BLAKE2S_OUTBYTES;
+
+	for (k = 0; k < 2; k++) {
+		keylen = k ? BLAKE2S_KEYBYTES : 0;
+		outlen = k ? BLAKE2S_OUTBYTES : BLAKE2S_OUTBYTES / 2;
+		for (i = 0; i < count; i++) {
+			blake2s_init_salt_personal(&S, outlen, key, keylen,
+						   NULL, NULL);
+			blake2s_update(&S, in + i * size, size);
+			blake2s_final(&S, want + i * outlen, outlen);
+		}
+
+		if (blake2s_digest_sectors(in, size, count, key, keylen, out,
+					   outlen) ||
+		    memcmp(out, want, count * outlen)) {
+			pr_err("blake2s: digest_sectors with a key of %zu bytes failed\n",
+			       keylen);
+			ret = -EINVAL;
+		}
+
+		want[3 * outlen] ^= 1;
+		if (blake2s_verify_sectors(in, size, count, key, keylen, want,
+					   outlen, mismatch, &nr_mismatch) ||
+		    nr_mismatch != 1 || bitmap_weight(mismatch, count) != 1 ||
+		    !test_bit(3, mismatch)) {
+			pr_err("blake2s: verify_sectors with a key of %zu bytes failed\n",
+			       keylen);
+			ret = -EINVAL;
+		}
+	}
+
+	kfree(want);
+	return ret;
+}
+#else
+#define blake2s_many_selftest(key, in)		(0)
+#define blake2s_sectors_selftest(key, in)	(0)
+#endif
+
+static int __init blake2s_selftest(void)
+{
+	u8 key[BLAKE2S_KEYBYTES];
+	size_t i;
+	u8 *in;
+	int ret;
+
+	if (IS_ENABLED(CONFIG_CRYPTO_MANAGER_DISABLE_TESTS))
+		return 0;
+
+	in = kmalloc(BLAKE2S_SELFTEST_MAXLEN, GFP_KERNEL);
+	if (!in)
+		return -ENOMEM;
+	for (i = 0; i < BLAKE2S_SELFTEST_MAXLEN; i++)
+		in[i] = (u8)i;
+	for (i = 0; i < BLAKE2S_KEYBYTES; i++)
+		key[i] = (u8)i;
+
+	ret = blake2sp_selftest(key, in) ?: blake2xs_selftest(key, in) ?:
+	      blake2s_many_selftest(key, in) ?:
+	      blake2s_sectors_selftest(key, in);
+
+	kfree(in);
+	return ret;
+}
@@ -0,0 +1,207 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * Synchronous ahash front end of the SIMD BLAKE2s drivers walking the
+ * request scatterlist, included by blake2s-glue.c
+ *
+ * The pages are mapped with kmap_local_page and hashed in place, whole blocks
+ * go to the compress backend and only a block tail is carried in S->buf
+ * across fragments. The FPU is held across fragments for up to
+ * BLAKE2S_FPU_CHUNK bytes.
+ */
+
+#include <linux/highmem.h>
+#include <linux/scatterlist.h>
+
+static __always_inline void __blake2s_sg_update(struct blake2s_state *S,
+						struct scatterlist *sg,
+						unsigned int nbytes,
+						blake2s_compress_t compress,
+						bool simd)
+{
+	size_t fpu_bytes = 0;
+
+	if (simd)
+		kernel_fpu_begin();
+	for (; nbytes; sg = sg_next(sg)) {
+		unsigned int len = min(sg->length, nbytes);
+		unsigned int offset = sg->offset;
+		struct page *page = sg_page(sg);
+
+		nbytes -= len;
+		while (len) {
+			unsigned int chunk = min_t(unsigned int, len,
+						   PAGE_SIZE - offset_in_page(offset));
+			const u8 *p = kmap_local_page(nth_page(page,
+							       offset / PAGE_SIZE));
+
+			__blake2s_update(S, p + offset_in_page(offset), chunk,
+					 compress);
+			kunmap_local(p);
+			offset += chunk;
+			len -= chunk;
+
+			fpu_bytes += chunk;
+			if (simd && fpu_bytes >= BLAKE2S_FPU_CHUNK) {
+				kernel_fpu_end();
+				kernel_fpu_begin();
+				fpu_bytes = 0;
+			}
+		}
+	}
+	if (simd)
+		kernel_fpu_end();
+}
+
+static void blake2s_sg_update(struct blake2s_state *S, struct scatterlist *sg,
+			      unsigned int nbytes)
+{
+	if (!static_branch_likely(&blake2s_use_simd) || !irq_fpu_usable())
+		return __blake2s_sg_update(S, sg, nbytes,
+					   blake2s_compress_generic, false);
+
+	__blake2s_sg_update(S, sg, nbytes, blake2s_compress_arch, true);
+}
+
+static int blake2s_sg_init(struct ahash_request *req)
+{
+	struct chksum_ctx *mctx = crypto_ahash_ctx(crypto_ahash_reqtfm(req));
+	struct chksum_desc_ctx *rctx = ahash_request_ctx(req);
+
+	*rctx->S = *mctx->S;
+	return 0;
+}
+
+static int blake2s_sg_update_req(struct ahash_request *req)
+{
+	struct chksum_desc_ctx *rctx = ahash_request_ctx(req);
+
+	blake2s_sg_update(rctx->S, req->src, req->nbytes);
+	return 0;
+}
+
+static int blake2s_sg_final(struct ahash_request *req)
+{
+	struct chksum_ctx *mctx = crypto_ahash_ctx(crypto_ahash_reqtfm(req));
+	struct chksum_desc_ctx *rctx = ahash_request_ctx(req);
+
+	return blake2s_ctx_final(mctx, rctx->S, req->result);
+}
+
+static int blake2s_sg_finup(struct ahash_request *req)
+{
+	blake2s_sg_update_req(req);
+	return blake2s_sg_final(req);
+}
+
+static int blake2s_sg_digest(struct ahash_request *req)
+{
+	blake2s_sg_init(req);
+	return blake2s_sg_finup(req);
+}
+
+static int blake2s_sg_export(struct ahash_request *req, void *out)
+{
+	struct chksum_desc_ctx *rctx = ahash_request_ctx(req);
+
+	blake2s_export_state(rctx->S, out);
+	return 0;
+}
+
+static int blake2s_sg_import(struct ahash_request *req, const void *in)
+{
+	struct chksum_desc_ctx *rctx = ahash_request_ctx(req);
+
+	return blake2s_import_state(rctx->S, in,
+				    crypto_ahash_digestsize(crypto_ahash_reqtfm(req)));
+}
+
+static int blake2s_sg_setkey(struct crypto_ahash *tfm, const u8 *key,
+			     unsigned int keylen)
+{
+	int ret;
+
+	ret = blake2s_ctx_setkey(crypto_ahash_ctx(tfm),
+				 crypto_ahash_digestsize(tfm), key, keylen);
+	if (ret)
+		crypto_ahash_set_flags(tfm, CRYPTO_TFM_RES_BAD_KEY_LEN);
+	return ret;
+}
+
+/* Unkeyed hashing until a key is set */
+static int blake2s_sg_init_tfm(struct crypto_ahash *tfm)
+{
+	struct chksum_ctx *mctx = crypto_ahash_ctx(tfm);
+
+	mctx->keylen = 0;
+	if (blake2s_init(mctx->S, crypto_ahash_digestsize(tfm)))
+		return -EINVAL;
+	crypto_ahash_set_reqsize(tfm, sizeof(struct chksum_desc_ctx));
+	return 0;
+}
+
+static int blake2s_sg_clone_tfm(struct crypto_ahash *dst,
+				struct crypto_ahash *src)
+{
+	memcpy(crypto_ahash_ctx(dst), crypto_ahash_ctx(src),
+	       sizeof(struct chksum_ctx));
+	return 0;
+}
+
+#define BLAKE2S_SG_ALG(digest_size)					\
+	{								\
+		.init		=	blake2s_sg_init,		\
+		.update		=	blake2s_sg_update_req,		\
+		.final		=	blake2s_sg_final,		\
+		.finup		=	blake2s_sg_finup,		\
+		.digest		=	blake2s_sg_digest,		\
+		.export		=	blake2s_sg_export,		\
+		.import		=	blake2s_sg_import,		\
+		.setkey		=	blake2s_sg_setkey,		\
+		.init_tfm	=	blake2s_sg_init_tfm,		\
+		.clone_tfm	=	blake2s_sg_clone_tfm,		\
+		.halg		=	{				\
+			.digestsize	=	digest_size,		\
+			.statesize	=	sizeof(struct chksum_export_state), \
+			.base		=	{			\
+				.cra_flags	=	CRYPTO_ALG_OPTIONAL_KEY, \
+				.cra_blocksize	=	1,		\
+				.cra_ctxsize	=	sizeof(struct chksum_ctx), \
+				.cra_module	=	THIS_MODULE,	\
+			}						\
+		}							\
+	}
+
+/* Named after the shash algs, in the same order */
+static struct ahash_alg blake2s_sg_algs[] = {
+	BLAKE2S_SG_ALG(BLAKE2S_OUTBYTES),
+	BLAKE2S_SG_ALG(16),
+	BLAKE2S_SG_ALG(20),
+	BLAKE2S_SG_ALG(28),
+};
+
+/*
+ * One above the shash of the same backend, ahash users get the scatterlist
+ * walk instead of the shash wrapper
+ */
+static int __init blake2s_sg_register(const struct blake2s_backend *b)
+{
+	int i;
+
+	BUILD_BUG_ON(ARRAY_SIZE(blake2s_sg_algs) != ARRAY_SIZE(algs));
+	for (i = 0; i < ARRAY_SIZE(blake2s_sg_algs); i++) {
+		struct crypto_alg *base = &blake2s_sg_algs[i].halg.base;
+
+		strscpy(base->cra_name, algs[i].base.cra_name,
+			CRYPTO_MAX_ALG_NAME);
+		snprintf(base->cra_driver_name, CRYPTO_MAX_ALG_NAME,
+			 "%s-sg-%s", algs[i].base.cra_name, b->driver_suffix);
+		base->cra_priority = b->priority + 1;
+	}
+	return crypto_register_ahashes(blake2s_sg_algs,
+				       ARRAY_SIZE(blake2s_sg_algs));
+}
+
+static void blake2s_sg_unregister(void)
+{
+	crypto_unregister_ahashes(blake2s_sg_algs, ARRAY_SIZE(blake2s_sg_algs));
+}
@@ -0,0 +1,265 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * Verity style BLAKE2s hash tree builder, included by blake2s-glue.c
+ *
+ * The format follows fs-verity. Each data block is hashed after a salt that
+ * is zero padded to one BLAKE2s block, and the last data block is zero
+ * padded. The digests are packed into zero padded hash blocks, which are
+ * hashed the same way, level by level, until one hash block is left. Its
+ * digest is the root. The levels are stored top down.
+ *
+ * A level is hashed in batches on the multi-buffer lanes, and every block
+ * starts from the state after the salt block. When a hash block of two
+ * digests fills one BLAKE2s block (64 bytes of BLAKE2s-256 digests), each
+ * interior node costs a single compress per lane.
+ */
+
+#include <linux/err.h>
+#include <linux/overflow.h>
+
+/* Two digests per hash block at least, halved until one block is left */
+#define BLAKE2S_VERITY_MAX_LEVELS	64
+
+/*
+ * Blocks per call into the multi-buffer batch. blake2s_mb_sectors() restarts
+ * its FPU section every BLAKE2S_MB_FPU_BLOCKS lane compresses, the bound
+ * keeps a multi-MiB level from being one call and rechecks irq_fpu_usable()
+ * between batches.
+ */
+#define BLAKE2S_VERITY_BATCH		256
+
+struct blake2s_verity {
+	struct blake2s_state salted;
+	u64 data_size;
+	u64 next;		/* data blocks hashed so far */
+	u32 data_block_size;
+	u32 hash_block_size;
+	u32 digest_size;
+	u32 hashes_per_block;
+	u32 levels;
+	bool packed;		/* no padding after the digests of a block */
+	u64 level_start[BLAKE2S_VERITY_MAX_LEVELS];	/* in hash blocks */
+	u64 level_blocks[BLAKE2S_VERITY_MAX_LEVELS];
+	size_t tree_size;
+	u8 root[BLAKE2S_OUTBYTES];
+	u8 *pad;		/* the last data block, zero padded */
+	u8 tree[];
+};
+
+static int blake2s_verity_layout(struct blake2s_verity *V, u64 data_size,
+				 u32 data_block_size, u32 hash_block_size,
+				 u32 digest_size)
+{
+	u64 n, start = 0;
+	u32 i;
+
+	if (!digest_size || digest_size > BLAKE2S_OUTBYTES)
+		return -EINVAL;
+	if (!data_block_size || hash_block_size < 2 * digest_size)
+		return -EINVAL;
+
+	V->data_size = data_size;
+	V->next = 0;
+	V->data_block_size = data_block_size;
+	V->hash_block_size = hash_block_size;
+	V->digest_size = digest_size;
+	V->hashes_per_block = hash_block_size / digest_size;
+	V->packed = hash_block_size % digest_size == 0;
+
+	V->levels = 0;
+	n = DIV_ROUND_UP_ULL(data_size, data_block_size);
+	while (n > 1) {
+		n = DIV_ROUND_UP_ULL(n, V->hashes_per_block);
+		V->level_blocks[V->levels++] = n;
+	}
+	for (i = V->levels; i-- > 0;) {
+		V->level_start[i] = start;
+		start += V->level_blocks[i];
+	}
+
+	if (start > (SIZE_MAX - data_block_size) / hash_block_size)
+		return -EINVAL;
+	V->tree_size = start * hash_block_size;
+	return 0;
+}
+
+/* count blocks of size bytes each into count digests at out */
+static void blake2s_verity_blocks(const struct blake2s_verity *V,
+				  const u8 *in, size_t size,
+				  unsigned int count, u8 *out)
+{
+	struct blake2s_state S;
+	unsigned int i;
+
+	if (count >= 2 && blake2s_mb_nr_lanes() && irq_fpu_usable()) {
+		blake2s_mb_sectors(&V->salted, in, size, count, out, NULL,
+				   NULL, V->digest_size);
+		return;
+	}
+
+	for (i = 0; i < count; i++) {
+		S = V->salted;
+		blake2s_finup_arch(&S, in + i * size, size,
+				   out + i * V->digest_size);
+	}
+	memzero_explicit(&S, sizeof(S));
+}
+
+/*
+ * The digests of count blocks of size bytes go to level from digest first
+ * on, level V->levels is the root
+ */
+static void blake2s_verity_hash(struct blake2s_verity *V, u32 level,
+				u64 first, const u8 *in, size_t size, u64 count)
+{
+	const u32 hpb = V->hashes_per_block;
+	unsigned int n;
+	u8 *out;
+
+	while (count) {
+		/* Digests are contiguous across hash blocks only if packed */
+		n = min_t(u64, count, BLAKE2S_VERITY_BATCH);
+		if (!V->packed)
+			n = min(n, hpb - (u32)(first % hpb));
+		if (level == V->levels)
+			out = V->root;
+		else
+			out = V->tree +
+			      (V->level_start[level] + first / hpb) *
+			      V->hash_block_size +
+			      (first % hpb) * V->digest_size;
+
+		blake2s_verity_blocks(V, in, size, n, out);
+		in += (size_t)n * size;
+		first += n;
+		count -= n;
+	}
+}
+
+/**
+ * blake2s_verity_alloc - hash tree builder for an object
+ * @data_size: object size in bytes
+ * @data_block_size: bytes per data block
+ * @hash_block_size: bytes per hash block, at least two digests
+ * @digest_size: digest length, 1 to BLAKE2S_OUTBYTES
+ * @salt: prepended to every block, NULL if unsalted
+ * @salt_size: length of the salt, 0 to BLAKE2S_BLOCKBYTES
+ * @gfp: allocation flags
+ *
+ * Feed the data in order with blake2s_verity_update(), then build the tree
+ * with blake2s_verity_final(). Returns an ERR_PTR() on failure.
+ */
+struct blake2s_verity *blake2s_verity_alloc(u64 data_size, u32 data_block_size,
+					    u32 hash_block_size,
+					    u32 digest_size, const u8 *salt,
+					    u32 salt_size, gfp_t gfp)
+{
+	struct blake2s_verity layout;
+	struct blake2s_verity *V;
+	int ret;
+
+	if (salt_size > BLAKE2S_BLOCKBYTES || (salt_size && !salt))
+		return ERR_PTR(-EINVAL);
+	ret = blake2s_verity_layout(&layout, data_size, data_block_size,
+				    hash_block_size, digest_size);
+	if (ret)
+		return ERR_PTR(ret);
+
+	V = kvzalloc(struct_size(V, tree, layout.tree_size + data_block_size),
+		     gfp);
+	if (!V)
+		return ERR_PTR(-ENOMEM);
+	*V = layout;
+	V->pad = V->tree + V->tree_size;
+
+	/* The salt block stays buffered and is compressed once per batch */
+	blake2s_init(&V->salted, digest_size);
+	if (salt_size) {
+		u8 block[BLAKE2S_BLOCKBYTES];
+
+		memset(block, 0, BLAKE2S_BLOCKBYTES);
+		memcpy(block, salt, salt_size);
+		blake2s_update(&V->salted, block, BLAKE2S_BLOCKBYTES);
+	}
+	return V;
+}
+EXPORT_SYMBOL_GPL(blake2s_verity_alloc);
+
+void blake2s_verity_free(struct blake2s_verity *V)
+{
+	kvfree(V);
+}
+EXPORT_SYMBOL_GPL(blake2s_verity_free);
+
+/**
+ * blake2s_verity_update - hash the next data blocks
+ * @V: the builder
+ * @data: the data following the previous call
+ * @len: a multiple of the data block size, or up to the end of the object
+ */
+int blake2s_verity_update(struct blake2s_verity *V, const void *data,
+			  size_t len)
+{
+	const u64 offset = V->next * V->data_block_size;
+	const u8 *in = data;
+	const size_t left = len % V->data_block_size;
+	const u64 full = len / V->data_block_size;
+
+	if (!len)
+		return 0;
+	if (offset > V->data_size || len > V->data_size - offset)
+		return -EINVAL;
+	if (left && offset + len != V->data_size)
+		return -EINVAL;
+
+	blake2s_verity_hash(V, 0, V->next, in, V->data_block_size, full);
+	V->next += full;
+
+	if (left) {
+		memcpy(V->pad, in + full * V->data_block_size, left);
+		memset(V->pad + left, 0, V->data_block_size - left);
+		blake2s_verity_hash(V, 0, V->next, V->pad, V->data_block_size,
+				    1);
+		V->next++;
+	}
+	return 0;
+}
+EXPORT_SYMBOL_GPL(blake2s_verity_update);
+
+/**
+ * blake2s_verity_final - hash the tree levels
+ * @V: the builder, all the data must have been fed
+ * @root: the root digest, digest_size bytes
+ *
+ * The root of an empty object is all zeros, as in fs-verity.
+ */
+int blake2s_verity_final(struct blake2s_verity *V, u8 *root)
+{
+	u32 level;
+
+	if (V->next != DIV_ROUND_UP_ULL(V->data_size, V->data_block_size))
+		return -EINVAL;
+	if (!V->data_size) {
+		memset(root, 0, V->digest_size);
+		return 0;
+	}
+
+	for (level = 1; level <= V->levels; level++)
+		blake2s_verity_hash(V, level, 0,
+				    V->tree + V->level_start[level - 1] *
+					      V->hash_block_size,
+				    V->hash_block_size,
+				    V->level_blocks[level - 1]);
+
+	memcpy(root, V->root, V->digest_size);
+	return 0;
+}
+EXPORT_SYMBOL_GPL(blake2s_verity_final);
+
+/* The hash blocks, top level first, valid after blake2s_verity_final() */
+const u8 *blake2s_verity_tree(const struct blake2s_verity *V, size_t *size)
+{
+	*size = V->tree_size;
+	return V->tree;
+}
+EXPORT_SYMBOL_GPL(blake2s_verity_tree);
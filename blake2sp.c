@@ -0,0 +1,308 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * BLAKE2sp, 8 BLAKE2s leaves hashing interleaved blocks and a root hashing
+ * the leaf digests, included by blake2s.c
+ *
+ * The state does not fit the shash descriptor size limit, the algorithm is
+ * registered as a synchronous ahash with the state in the request.
+ */
+
+#define BLAKE2SP_STRIPE		(BLAKE2SP_LEAVES * BLAKE2S_BLOCKBYTES)
+
+/* Block i of each stripe to leaf i, the leaves buffer their last block */
+typedef void (*blake2sp_stripes_t)(struct blake2s_state *S, const u8 *in,
+				   size_t nstripes);
+
+static void blake2sp_init_node(struct blake2s_state *S, size_t outlen,
+			       size_t keylen, u32 offset, u8 depth)
+{
+	struct blake2s_param P[1];
+
+	P->digest_length = (u8)outlen;
+	P->key_length    = (u8)keylen;
+	P->fanout        = BLAKE2SP_LEAVES;
+	P->depth         = 2;
+	store32(&P->leaf_length, 0);
+	store32(&P->node_offset, offset);
+	store16(&P->xof_length, 0);
+	P->node_depth    = depth;
+	P->inner_length  = BLAKE2S_OUTBYTES;
+	memset(P->salt,     0, sizeof(P->salt));
+	memset(P->personal, 0, sizeof(P->personal));
+	blake2s_init_param(S, P);
+}
+
+static int __blake2sp_init(struct blake2sp_state *S, size_t outlen,
+			   const void *key, size_t keylen)
+{
+	size_t i;
+
+	if ((!outlen) || (outlen > BLAKE2S_OUTBYTES))
+		return -1;
+
+	if (keylen > BLAKE2S_KEYBYTES)
+		return -1;
+
+	memset(S->buf, 0, sizeof(S->buf));
+	S->buflen = 0;
+	S->outlen = outlen;
+
+	blake2sp_init_node(&S->R, outlen, keylen, 0, 1);
+	S->R.last_node = 1;
+	for (i = 0; i < BLAKE2SP_LEAVES; ++i) {
+		blake2sp_init_node(&S->S[i], outlen, keylen, i, 0);
+		/* The leaves output the full inner length */
+		S->S[i].outlen = BLAKE2S_OUTBYTES;
+	}
+	S->S[BLAKE2SP_LEAVES - 1].last_node = 1;
+
+	/* Only the leaves hash the key block */
+	if (keylen) {
+		u8 block[BLAKE2S_BLOCKBYTES];
+
+		memset(block, 0, BLAKE2S_BLOCKBYTES);
+		memcpy(block, key, keylen);
+		for (i = 0; i < BLAKE2SP_LEAVES; ++i)
+			blake2s_update(&S->S[i], block, BLAKE2S_BLOCKBYTES);
+		memzero_explicit(block, BLAKE2S_BLOCKBYTES);
+	}
+	return 0;
+}
+
+int blake2sp_init(struct blake2sp_state *S, size_t outlen)
+{
+	return __blake2sp_init(S, outlen, NULL, 0);
+}
+
+int blake2sp_init_key(struct blake2sp_state *S, size_t outlen, const void *key,
+		      size_t keylen)
+{
+	if (!key || !keylen)
+		return -1;
+
+	return __blake2sp_init(S, outlen, key, keylen);
+}
+
+static void blake2sp_stripes_generic(struct blake2s_state *S, const u8 *in,
+				     size_t nstripes)
+{
+	size_t i, k;
+
+	for (i = 0; i < BLAKE2SP_LEAVES; ++i)
+		for (k = 0; k < nstripes; ++k)
+			blake2s_update(&S[i], in + k * BLAKE2SP_STRIPE +
+					      i * BLAKE2S_BLOCKBYTES,
+				       BLAKE2S_BLOCKBYTES);
+}
+
+static __always_inline int __blake2sp_update(struct blake2sp_state *S,
+					     const void *pin, size_t inlen,
+					     blake2sp_stripes_t stripes)
+{
+	const u8 *in = pin;
+	size_t left = S->buflen;
+	size_t fill = BLAKE2SP_STRIPE - left;
+	size_t nstripes;
+
+	if (left && inlen >= fill) {
+		memcpy(S->buf + left, in, fill);
+		stripes(S->S, S->buf, 1);
+		in += fill;
+		inlen -= fill;
+		left = 0;
+	}
+
+	nstripes = inlen / BLAKE2SP_STRIPE;
+	if (nstripes) {
+		stripes(S->S, in, nstripes);
+		in += nstripes * BLAKE2SP_STRIPE;
+		inlen -= nstripes * BLAKE2SP_STRIPE;
+	}
+
+	memcpy(S->buf + left, in, inlen);
+	S->buflen = left + inlen;
+	return 0;
+}
+
+/* The buffered stripe to the leaves, then the leaf digests to the root */
+static __always_inline int __blake2sp_final(struct blake2sp_state *S,
+					    void *out, size_t outlen,
+					    int (*update)(struct blake2s_state *,
+							  const void *, size_t),
+					    int (*final)(struct blake2s_state *,
+							 void *, size_t))
+{
+	u8 hash[BLAKE2SP_LEAVES][BLAKE2S_OUTBYTES];
+	size_t i;
+	int ret;
+
+	if (out == NULL || outlen < S->outlen)
+		return -1;
+
+	for (i = 0; i < BLAKE2SP_LEAVES; ++i) {
+		if (S->buflen > i * BLAKE2S_BLOCKBYTES) {
+			size_t left = min_t(size_t,
+					    S->buflen - i * BLAKE2S_BLOCKBYTES,
+					    BLAKE2S_BLOCKBYTES);
+
+			update(&S->S[i], S->buf + i * BLAKE2S_BLOCKBYTES, left);
+		}
+		final(&S->S[i], hash[i], BLAKE2S_OUTBYTES);
+	}
+
+	for (i = 0; i < BLAKE2SP_LEAVES; ++i)
+		update(&S->R, hash[i], BLAKE2S_OUTBYTES);
+
+	ret = final(&S->R, out, S->outlen);
+	memzero_explicit(hash, sizeof(hash));
+	return ret;
+}
+
+int blake2sp_update(struct blake2sp_state *S, const void *pin, size_t inlen)
+{
+	return __blake2sp_update(S, pin, inlen, blake2sp_stripes_generic);
+}
+
+int blake2sp_final(struct blake2sp_state *S, void *out, size_t outlen)
+{
+	return __blake2sp_final(S, out, outlen, blake2s_update, blake2s_final);
+}
+
+#ifdef BLAKE2S_SIMD
+/* Defined in blake2s-glue.c, the leaves run on the multi-buffer lanes */
+static int blake2sp_update_arch(struct blake2sp_state *S, const void *pin,
+				size_t inlen);
+static int blake2sp_final_arch(struct blake2sp_state *S, void *out,
+			       size_t outlen);
+#else
+#define blake2sp_update_arch		blake2sp_update
+#define blake2sp_final_arch		blake2sp_final
+#endif
+
+/* With a key set, S holds the state after the key blocks so init is a copy */
+struct blake2sp_ctx {
+	struct blake2sp_state S[1];
+	unsigned int keylen;
+};
+
+struct blake2sp_reqctx {
+	struct blake2sp_state S[1];
+};
+
+static int blake2sp_init_req(struct ahash_request *req)
+{
+	struct crypto_ahash *tfm = crypto_ahash_reqtfm(req);
+	struct blake2sp_ctx *mctx = crypto_ahash_ctx(tfm);
+	struct blake2sp_reqctx *rctx = ahash_request_ctx(req);
+
+	/* Unkeyed hashing until a key is set */
+	if (mctx->keylen) {
+		*rctx->S = *mctx->S;
+		return 0;
+	}
+	if (blake2sp_init(rctx->S, crypto_ahash_digestsize(tfm)))
+		return -EINVAL;
+	return 0;
+}
+
+static int blake2sp_setkey(struct crypto_ahash *tfm, const u8 *key,
+			   unsigned int keylen)
+{
+	struct blake2sp_ctx *mctx = crypto_ahash_ctx(tfm);
+
+	if (!keylen || keylen > BLAKE2S_KEYBYTES)
+		return -EINVAL;
+	if (blake2sp_init_key(mctx->S, crypto_ahash_digestsize(tfm), key,
+			      keylen))
+		return -EINVAL;
+
+	mctx->keylen = keylen;
+	return 0;
+}
+
+static int blake2sp_update_req(struct ahash_request *req)
+{
+	struct blake2sp_reqctx *rctx = ahash_request_ctx(req);
+	struct crypto_hash_walk walk;
+	int nbytes;
+
+	for (nbytes = crypto_hash_walk_first(req, &walk); nbytes > 0;
+	     nbytes = crypto_hash_walk_done(&walk, 0))
+		blake2sp_update_arch(rctx->S, walk.data, nbytes);
+
+	return nbytes;
+}
+
+static int blake2sp_final_req(struct ahash_request *req)
+{
+	struct blake2sp_reqctx *rctx = ahash_request_ctx(req);
+	int ret;
+
+	ret = blake2sp_final_arch(rctx->S, req->result, rctx->S->outlen);
+	memzero_explicit(rctx->S, sizeof(rctx->S));
+	if (ret)
+		return -EINVAL;
+	return 0;
+}
+
+static int blake2sp_finup_req(struct ahash_request *req)
+{
+	int ret;
+
+	ret = blake2sp_update_req(req);
+	if (ret)
+		return ret;
+	return blake2sp_final_req(req);
+}
+
+static int blake2sp_digest_req(struct ahash_request *req)
+{
+	int ret;
+
+	ret = blake2sp_init_req(req);
+	if (ret)
+		return ret;
+	return blake2sp_finup_req(req);
+}
+
+static int blake2sp_init_tfm(struct crypto_ahash *tfm)
+{
+	struct blake2sp_ctx *mctx = crypto_ahash_ctx(tfm);
+
+	mctx->keylen = 0;
+	crypto_ahash_set_reqsize(tfm, sizeof(struct blake2sp_reqctx));
+	return 0;
+}
+
+/* The keyed state is plain data, a clone shares it without a setkey */
+static int blake2sp_clone_tfm(struct crypto_ahash *dst,
+			      struct crypto_ahash *src)
+{
+	memcpy(crypto_ahash_ctx(dst), crypto_ahash_ctx(src),
+	       sizeof(struct blake2sp_ctx));
+	return 0;
+}
+
+/* No export and import, the state is larger than HASH_MAX_STATESIZE */
+static struct ahash_alg blake2sp_alg = {
+	.init		=	blake2sp_init_req,
+	.update		=	blake2sp_update_req,
+	.final		=	blake2sp_final_req,
+	.finup		=	blake2sp_finup_req,
+	.digest		=	blake2sp_digest_req,
+	.setkey		=	blake2sp_setkey,
+	.init_tfm	=	blake2sp_init_tfm,
+	.clone_tfm	=	blake2sp_clone_tfm,
+	.halg		=	{
+		.digestsize	=	BLAKE2S_OUTBYTES,
+		.base		=	{
+			.cra_name		=	"blake2sp",
+			.cra_driver_name	=	"blake2sp-generic",
+			.cra_priority		=	100,
+			.cra_flags		=	CRYPTO_ALG_OPTIONAL_KEY,
+			.cra_blocksize		=	1,
+			.cra_ctxsize		=	sizeof(struct blake2sp_ctx),
+			.cra_module		=	THIS_MODULE,
+		}
+	}
+};
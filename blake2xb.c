@@ -0,0 +1,180 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * BLAKE2Xb extendable output, included by blake2b.c
+ *
+ * The input is hashed to a root of BLAKE2B_OUTBYTES with the output length in
+ * the xof_length parameter. Output block i is a one block hash of the root
+ * with node offset i, so the blocks are independent of each other.
+ */
+
+/* Full output blocks first to first + nblocks - 1, C is node offset 0 */
+typedef void (*blake2xb_blocks_t)(const struct blake2b_state *C,
+				  const u8 *root, u32 first, size_t nblocks,
+				  u8 *out);
+
+static int __blake2xb_init(struct blake2xb_state *S, size_t outlen,
+			   const void *key, size_t keylen)
+{
+	struct blake2b_param *P = S->P;
+
+	if (!outlen || outlen > BLAKE2XB_UNKNOWN_LENGTH)
+		return -1;
+
+	if (keylen > BLAKE2B_KEYBYTES)
+		return -1;
+
+	P->digest_length = BLAKE2B_OUTBYTES;
+	P->key_length    = (u8)keylen;
+	P->fanout        = 1;
+	P->depth         = 1;
+	store32(&P->leaf_length, 0);
+	store32(&P->node_offset, 0);
+	store32(&P->xof_length, outlen);
+	P->node_depth    = 0;
+	P->inner_length  = 0;
+	memset(P->reserved, 0, sizeof(P->reserved));
+	memset(P->salt,     0, sizeof(P->salt));
+	memset(P->personal, 0, sizeof(P->personal));
+	blake2b_init_param(S->S, P);
+
+	if (keylen) {
+		u8 block[BLAKE2B_BLOCKBYTES];
+
+		memset(block, 0, BLAKE2B_BLOCKBYTES);
+		memcpy(block, key, keylen);
+		blake2b_update(S->S, block, BLAKE2B_BLOCKBYTES);
+		memzero_explicit(block, BLAKE2B_BLOCKBYTES);
+	}
+	return 0;
+}
+
+/*
+ * Output length outlen, BLAKE2XB_UNKNOWN_LENGTH leaves it to
+ * blake2xb_final()
+ */
+int blake2xb_init(struct blake2xb_state *S, size_t outlen)
+{
+	return __blake2xb_init(S, outlen, NULL, 0);
+}
+
+int blake2xb_init_key(struct blake2xb_state *S, size_t outlen,
+		      const void *key, size_t keylen)
+{
+	if (!key || !keylen)
+		return -1;
+
+	return __blake2xb_init(S, outlen, key, keylen);
+}
+
+static __always_inline void __blake2xb_blocks(const struct blake2b_state *C,
+					      const u8 *root, u32 first,
+					      size_t nblocks, u8 *out,
+					      int (*update)(struct blake2b_state *,
+							    const void *, size_t),
+					      int (*final)(struct blake2b_state *,
+							   void *, size_t))
+{
+	struct blake2b_state S;
+	size_t i;
+
+	for (i = 0; i < nblocks; ++i) {
+		S = *C;
+		/* The node offset is the low half of parameter word 1 */
+		S.h[1] ^= first + i;
+		update(&S, root, BLAKE2B_OUTBYTES);
+		final(&S, out + i * BLAKE2B_OUTBYTES, BLAKE2B_OUTBYTES);
+	}
+	memzero_explicit(&S, sizeof(S));
+}
+
+static __always_inline int __blake2xb_final(struct blake2xb_state *S,
+					    void *pout, size_t outlen,
+					    int (*final)(struct blake2b_state *,
+							 void *, size_t),
+					    blake2xb_blocks_t blocks)
+{
+	const u32 xof_length = load32(&S->P->xof_length);
+	const size_t nblocks = outlen / BLAKE2B_OUTBYTES;
+	const size_t left = outlen % BLAKE2B_OUTBYTES;
+	u8 root[BLAKE2B_OUTBYTES];
+	u8 last[BLAKE2B_OUTBYTES];
+	struct blake2b_param P[1];
+	struct blake2b_state C;
+	u8 *out = pout;
+
+	if (out == NULL || !outlen)
+		return -1;
+
+	if (xof_length == BLAKE2XB_UNKNOWN_LENGTH) {
+		/* The node offset of the last block must fit */
+		if ((outlen - 1) / BLAKE2B_OUTBYTES > U32_MAX)
+			return -1;
+	} else if (outlen != xof_length) {
+		return -1;
+	}
+
+	final(S->S, root, BLAKE2B_OUTBYTES);
+
+	*P = *S->P;
+	P->digest_length = BLAKE2B_OUTBYTES;
+	P->key_length    = 0;
+	P->fanout        = 0;
+	P->depth         = 0;
+	store32(&P->leaf_length, BLAKE2B_OUTBYTES);
+	P->node_depth    = 0;
+	P->inner_length  = BLAKE2B_OUTBYTES;
+	blake2b_init_param(&C, P);
+	blocks(&C, root, 0, nblocks, out);
+
+	/* A partial last block has its own digest length */
+	if (left) {
+		P->digest_length = (u8)left;
+		blake2b_init_param(&C, P);
+		blocks(&C, root, nblocks, 1, last);
+		memcpy(out + nblocks * BLAKE2B_OUTBYTES, last, left);
+	}
+
+	memzero_explicit(root, sizeof(root));
+	memzero_explicit(last, sizeof(last));
+	memzero_explicit(&C, sizeof(C));
+	memzero_explicit(S, sizeof(*S));
+	return 0;
+}
+
+/* Also the reference for the _arch blocks in the self-test */
+static void blake2xb_blocks_generic(const struct blake2b_state *C,
+				    const u8 *root, u32 first, size_t nblocks,
+				    u8 *out)
+{
+	__blake2xb_blocks(C, root, first, nblocks, out, blake2b_update,
+			  blake2b_final);
+}
+
+#ifdef BLAKE2B_SIMD
+/* Defined in blake2b-glue.c, the output blocks run on the multi-buffer lanes */
+static void blake2xb_blocks_arch(const struct blake2b_state *C,
+				 const u8 *root, u32 first, size_t nblocks,
+				 u8 *out);
+#else
+#define blake2xb_blocks_arch		blake2xb_blocks_generic
+#endif
+
+int blake2xb_update(struct blake2xb_state *S, const void *in, size_t inlen)
+{
+	return blake2b_update_arch(S->S, in, inlen);
+}
+
+/* outlen must be the length from init unless that was unknown */
+int blake2xb_final(struct blake2xb_state *S, void *out, size_t outlen)
+{
+	return __blake2xb_final(S, out, outlen, blake2b_final_arch,
+				blake2xb_blocks_arch);
+}
+
+/* Only one of the generic and the SIMD module may export them */
+#ifdef BLAKE2B_SIMD
+EXPORT_SYMBOL_GPL(blake2xb_init);
+EXPORT_SYMBOL_GPL(blake2xb_init_key);
+EXPORT_SYMBOL_GPL(blake2xb_update);
+EXPORT_SYMBOL_GPL(blake2xb_final);
+#endif
@@ -17,7 +17,11 @@
 #ifndef BLAKE2_H
 #define BLAKE2_H
 
+#include <linux/bug.h>
 #include <linux/compiler.h>
+#include <linux/errno.h>
+#include <linux/string.h>
+#include <linux/types.h>
 #include <stddef.h>
 
 enum blake2s_constant
@@ -38,6 +42,18 @@ enum blake2b_constant
 	BLAKE2B_PERSONALBYTES = 16
 };
 
+enum blake2b_iv
+{
+	BLAKE2B_IV0 = 0x6a09e667f3bcc908ULL,
+	BLAKE2B_IV1 = 0xbb67ae8584caa73bULL,
+	BLAKE2B_IV2 = 0x3c6ef372fe94f82bULL,
+	BLAKE2B_IV3 = 0xa54ff53a5f1d36f1ULL,
+	BLAKE2B_IV4 = 0x510e527fade682d1ULL,
+	BLAKE2B_IV5 = 0x9b05688c2b3e6c1fULL,
+	BLAKE2B_IV6 = 0x1f83d9abfb41bd6bULL,
+	BLAKE2B_IV7 = 0x5be0cd19137e2179ULL
+};
+
 struct blake2s_state
 {
 	u32      h[8];
@@ -49,6 +65,20 @@ struct blake2s_state
 	u8  last_node;
 };
 
+/* Multi-buffer kernels hash up to BLAKE2S_MB_LANES messages in parallel */
+#define BLAKE2S_MB_LANES 16
+
+/*
+ * Transposed state, word i of lane l is h[i][l] and the counter of lane l is
+ * t[0][l], t[1][l]. f is the last block flag of each lane.
+ */
+struct blake2s_mb_state
+{
+	u32      h[8][BLAKE2S_MB_LANES];
+	u32      t[2][BLAKE2S_MB_LANES];
+	u32      f[BLAKE2S_MB_LANES];
+};
+
 struct blake2b_state
 {
 	u64      h[8];
@@ -61,6 +91,46 @@ struct blake2b_state
 };
 typedef struct blake2b_state blake2b_state;
 
+/* Multi-buffer kernels hash up to BLAKE2B_MB_LANES messages in parallel */
+#define BLAKE2B_MB_LANES 8
+
+/*
+ * Transposed state, word i of lane l is h[i][l]. The high counter word is
+ * always zero, f is the last block flag of each lane.
+ */
+struct blake2b_mb_state
+{
+	u64      h[8][BLAKE2B_MB_LANES];
+	u64      t[BLAKE2B_MB_LANES];
+	u64      f[BLAKE2B_MB_LANES];
+};
+
+/*
+ * BLAKE2sp and BLAKE2bp, block i of the message goes to leaf i mod the number
+ * of leaves and the root hashes the leaf digests. The buffer holds up to one
+ * stripe, a block for each leaf, the leaves buffer their last block.
+ */
+#define BLAKE2SP_LEAVES 8
+#define BLAKE2BP_LEAVES 4
+
+struct blake2sp_state
+{
+	struct blake2s_state S[BLAKE2SP_LEAVES];
+	struct blake2s_state R;
+	u8       buf[BLAKE2SP_LEAVES * BLAKE2S_BLOCKBYTES];
+	size_t   buflen;
+	size_t   outlen;
+};
+
+struct blake2bp_state
+{
+	struct blake2b_state S[BLAKE2BP_LEAVES];
+	struct blake2b_state R;
+	u8       buf[BLAKE2BP_LEAVES * BLAKE2B_BLOCKBYTES];
+	size_t   buflen;
+	size_t   outlen;
+};
+
 struct blake2s_param
 {
 	u8  digest_length; /* 1 */
@@ -92,17 +162,264 @@ struct blake2b_param
 	u8  personal[BLAKE2B_PERSONALBYTES];  /* 64 */
 } __packed;
 
+/*
+ * Extended setkey of the blake2s and blake2b shash algorithms, a key of
+ * keylen bytes (0 for none) with salt and personalization. A setkey of
+ * exactly this size is parsed as the struct, a shorter one is a plain key.
+ */
+struct blake2s_setkey_param
+{
+	u8  keylen;
+	u8  key[BLAKE2S_KEYBYTES];
+	u8  salt[BLAKE2S_SALTBYTES];
+	u8  personal[BLAKE2S_PERSONALBYTES];
+} __packed;
+
+struct blake2b_setkey_param
+{
+	u8  keylen;
+	u8  key[BLAKE2B_KEYBYTES];
+	u8  salt[BLAKE2B_SALTBYTES];
+	u8  personal[BLAKE2B_PERSONALBYTES];
+} __packed;
+
+/*
+ * BLAKE2Xs and BLAKE2Xb, the parameter block of the input hash is kept for
+ * the output blocks. The all ones xof_length is an output length that is
+ * only known at final.
+ */
+#define BLAKE2XS_UNKNOWN_LENGTH	0xffffU
+#define BLAKE2XB_UNKNOWN_LENGTH	0xffffffffU
+
+struct blake2xs_state
+{
+	struct blake2s_state S[1];
+	struct blake2s_param P[1];
+};
+
+struct blake2xb_state
+{
+	struct blake2b_state S[1];
+	struct blake2b_param P[1];
+};
+
 /* Streaming API */
 int blake2s_init(struct blake2s_state *S, size_t outlen);
 int blake2s_init_key(struct blake2s_state *S, size_t outlen, const void *key, size_t keylen);
 int blake2s_init_param(struct blake2s_state *S, const struct blake2s_param *P);
+int blake2s_init_salt_personal(struct blake2s_state *S, size_t outlen,
+			       const void *key, size_t keylen,
+			       const void *salt, const void *personal);
 int blake2s_update(struct blake2s_state *S, const void *in, size_t inlen);
 int blake2s_final(struct blake2s_state *S, void *out, size_t outlen);
 
+/*
+ * Batch API, digests of n independent messages into out[n][outlen]. Message
+ * i is keyed with key[i] when key and keylen[i] are set.
+ */
+int blake2s_digest_many(unsigned int n, const u8 *const data[],
+			const size_t len[], const u8 *const key[],
+			const size_t keylen[], u8 *out, size_t outlen);
+
+/*
+ * Per-sector checksums of count sectors at base into out[count][outlen], or
+ * checked against sums[count][outlen] with a bitmap and a count of the
+ * mismatches, both return 0 or -EINVAL
+ */
+int blake2s_digest_sectors(const void *base, size_t sector_size,
+			   unsigned int count, const u8 *key, size_t keylen,
+			   u8 *out, size_t outlen);
+int blake2s_verify_sectors(const void *base, size_t sector_size,
+			   unsigned int count, const u8 *key, size_t keylen,
+			   const u8 *sums, size_t outlen,
+			   unsigned long *mismatch, unsigned int *nr_mismatch);
+
+/* The same data into n states at once, finish each with blake2s_final() */
+int blake2s_update_many(struct blake2s_state *const S[], unsigned int n,
+			const void *in, size_t inlen);
+
+int blake2sp_init(struct blake2sp_state *S, size_t outlen);
+int blake2sp_init_key(struct blake2sp_state *S, size_t outlen, const void *key, size_t keylen);
+int blake2sp_update(struct blake2sp_state *S, const void *in, size_t inlen);
+int blake2sp_final(struct blake2sp_state *S, void *out, size_t outlen);
+
+int blake2xs_init(struct blake2xs_state *S, size_t outlen);
+int blake2xs_init_key(struct blake2xs_state *S, size_t outlen, const void *key, size_t keylen);
+int blake2xs_update(struct blake2xs_state *S, const void *in, size_t inlen);
+int blake2xs_final(struct blake2xs_state *S, void *out, size_t outlen);
+
 int blake2b_init(struct blake2b_state *S, size_t outlen);
 int blake2b_init_key(struct blake2b_state *S, size_t outlen, const void *key, size_t keylen);
 int blake2b_init_param(struct blake2b_state *S, const struct blake2b_param *P);
+int blake2b_init_salt_personal(struct blake2b_state *S, size_t outlen,
+			       const void *key, size_t keylen,
+			       const void *salt, const void *personal);
 int blake2b_update(struct blake2b_state *S, const void *in, size_t inlen);
 int blake2b_final(struct blake2b_state *S, void *out, size_t outlen);
 
+/* Batch API, unkeyed digests of n independent messages into out[n][outlen] */
+int blake2b_digest_many(unsigned int n, const u8 *const data[],
+			const size_t len[], u8 *out, size_t outlen);
+
+/*
+ * Per-sector checksums of count sectors at base into out[count][outlen], or
+ * checked against sums[count][outlen] with a bitmap and a count of the
+ * mismatches, both return 0 or -EINVAL
+ */
+int blake2b_digest_sectors(const void *base, size_t sector_size,
+			   unsigned int count, const u8 *key, size_t keylen,
+			   u8 *out, size_t outlen);
+int blake2b_verify_sectors(const void *base, size_t sector_size,
+			   unsigned int count, const u8 *key, size_t keylen,
+			   const u8 *sums, size_t outlen,
+			   unsigned long *mismatch, unsigned int *nr_mismatch);
+
+/* The same data into n states at once, finish each with blake2b_final() */
+int blake2b_update_many(struct blake2b_state *const S[], unsigned int n,
+			const void *in, size_t inlen);
+
+int blake2bp_init(struct blake2bp_state *S, size_t outlen);
+int blake2bp_init_key(struct blake2bp_state *S, size_t outlen, const void *key, size_t keylen);
+int blake2bp_update(struct blake2bp_state *S, const void *in, size_t inlen);
+int blake2bp_final(struct blake2bp_state *S, void *out, size_t outlen);
+
+int blake2xb_init(struct blake2xb_state *S, size_t outlen);
+int blake2xb_init_key(struct blake2xb_state *S, size_t outlen, const void *key, size_t keylen);
+int blake2xb_update(struct blake2xb_state *S, const void *in, size_t inlen);
+int blake2xb_final(struct blake2xb_state *S, void *out, size_t outlen);
+
+/*
+ * Tree mode over a scatterlist, leaves of BLAKE2B_TREE_LEAFBYTES hashed on
+ * several CPUs and a root over the leaf digests
+ */
+#define BLAKE2B_TREE_LEAFBYTES	65536
+
+struct scatterlist;
+int blake2b_tree_digest(struct scatterlist *sg, unsigned int nbytes,
+			const u8 *key, unsigned int keylen, u8 *out,
+			unsigned int outlen);
+
+/*
+ * Incremental Merkle tree over fixed size leaves, a leaf range update
+ * rehashes the path to the root only. The node cache can be saved and
+ * restored.
+ */
+struct blake2b_merkle;
+struct blake2b_merkle *blake2b_merkle_alloc(u64 size, u32 leaf_size,
+					    gfp_t gfp);
+void blake2b_merkle_free(struct blake2b_merkle *M);
+int blake2b_merkle_update(struct blake2b_merkle *M, u64 offset,
+			  const void *data, size_t len);
+void blake2b_merkle_root(const struct blake2b_merkle *M, u8 *out);
+size_t blake2b_merkle_cache_size(const struct blake2b_merkle *M);
+int blake2b_merkle_save(const struct blake2b_merkle *M, void *buf, size_t len);
+struct blake2b_merkle *blake2b_merkle_restore(const void *buf, size_t len,
+					      gfp_t gfp);
+
+/*
+ * fs-verity style hash tree over data blocks, each block hashed after a salt
+ * padded to one block. The levels are hashed in batches on the multi-buffer
+ * lanes.
+ */
+struct blake2b_verity;
+struct blake2b_verity *blake2b_verity_alloc(u64 data_size, u32 data_block_size,
+					    u32 hash_block_size,
+					    u32 digest_size, const u8 *salt,
+					    u32 salt_size, gfp_t gfp);
+void blake2b_verity_free(struct blake2b_verity *V);
+int blake2b_verity_update(struct blake2b_verity *V, const void *data,
+			  size_t len);
+int blake2b_verity_final(struct blake2b_verity *V, u8 *root);
+const u8 *blake2b_verity_tree(const struct blake2b_verity *V, size_t *size);
+
+struct blake2s_verity;
+struct blake2s_verity *blake2s_verity_alloc(u64 data_size, u32 data_block_size,
+					    u32 hash_block_size,
+					    u32 digest_size, const u8 *salt,
+					    u32 salt_size, gfp_t gfp);
+void blake2s_verity_free(struct blake2s_verity *V);
+int blake2s_verity_update(struct blake2s_verity *V, const void *data,
+			  size_t len);
+int blake2s_verity_final(struct blake2s_verity *V, u8 *root);
+const u8 *blake2s_verity_tree(const struct blake2s_verity *V, size_t *size);
+
+/*
+ * Library API without a tfm, like the kernel's lib/crypto blake2s. The
+ * initialization is inline so a constant digest length folds into the IV,
+ * update and final run on the SIMD backend. The state is wiped by final.
+ */
+void blake2b_lib_update(struct blake2b_state *S, const u8 *in, size_t inlen);
+void blake2b_lib_final(struct blake2b_state *S, u8 *out);
+void blake2b_lib_finup(struct blake2b_state *S, const u8 *in, size_t inlen,
+		       u8 *out);
+
+/*
+ * Same state as blake2b_init_key(), the key block stays buffered. With
+ * constant lengths the checks fold away.
+ */
+static inline int __blake2b_lib_init(struct blake2b_state *S, size_t outlen,
+				     const void *key, size_t keylen)
+{
+	if (WARN_ON(!outlen || outlen > BLAKE2B_OUTBYTES ||
+		    keylen > BLAKE2B_KEYBYTES || (!key && keylen)))
+		return -EINVAL;
+
+	S->h[0] = BLAKE2B_IV0 ^ (0x01010000 | keylen << 8 | outlen);
+	S->h[1] = BLAKE2B_IV1;
+	S->h[2] = BLAKE2B_IV2;
+	S->h[3] = BLAKE2B_IV3;
+	S->h[4] = BLAKE2B_IV4;
+	S->h[5] = BLAKE2B_IV5;
+	S->h[6] = BLAKE2B_IV6;
+	S->h[7] = BLAKE2B_IV7;
+	S->t[0] = 0;
+	S->t[1] = 0;
+	S->f[0] = 0;
+	S->f[1] = 0;
+	S->buflen = 0;
+	S->outlen = outlen;
+	S->last_node = 0;
+	if (keylen) {
+		memcpy(S->buf, key, keylen);
+		memset(S->buf + keylen, 0, BLAKE2B_BLOCKBYTES - keylen);
+		S->buflen = BLAKE2B_BLOCKBYTES;
+	}
+	return 0;
+}
+
+static inline int blake2b_lib_init(struct blake2b_state *S, size_t outlen)
+{
+	return __blake2b_lib_init(S, outlen, NULL, 0);
+}
+
+static inline int blake2b_lib_init_key(struct blake2b_state *S,
+				       size_t outlen, const void *key,
+				       size_t keylen)
+{
+	if (WARN_ON(!key || !keylen))
+		return -EINVAL;
+
+	return __blake2b_lib_init(S, outlen, key, keylen);
+}
+
+/*
+ * One-shot digest of in, keyed when keylen is set. A single call hashes the
+ * full blocks from in and pads only the tail. An unkeyed message of up to
+ * one block is one compress, a keyed one compresses the key block first.
+ */
+static inline int blake2b(u8 *out, const u8 *in, const u8 *key,
+			  const size_t outlen, const size_t inlen,
+			  const size_t keylen)
+{
+	struct blake2b_state S;
+
+	if (WARN_ON(!out || (!in && inlen)))
+		return -EINVAL;
+	if (__blake2b_lib_init(&S, outlen, key, keylen))
+		return -EINVAL;
+
+	blake2b_lib_finup(&S, in, inlen, out);
+	return 0;
+}
+
 #endif
@@ -34,3 +34,30 @@ int blake2b_compress(struct blake2b_state *S, const uint8_t block[BLAKE2B_BLOCKB
 
     return 0;
 }
+
+/*
+ * Compress nblocks consecutive blocks, adding inc to the counter before each
+ * one. The finalization flags are taken from S as set by the caller. The
+ * chaining value and the counter are written back once at the end.
+ */
+void blake2b_compress_blocks(struct blake2b_state *S, const uint8_t *in,
+                             size_t nblocks, uint32_t inc)
+{
+    __m256i  a = LOADU(&S->h[0]);
+    __m256i  b = LOADU(&S->h[4]);
+    uint64_t ctr0 = S->t[0];
+    uint64_t ctr1 = S->t[1];
+    const uint64_t flag0 = S->f[0];
+    const uint64_t flag1 = S->f[1];
+
+    while (nblocks--) {
+        ctr0 += inc;
+        ctr1 += (ctr0 < inc);
+        BLAKE2B_COMPRESS_V1(a, b, in, ctr0, ctr1, flag0, flag1);
+        in += BLAKE2B_BLOCKBYTES;
+    }
+    STOREU(&S->h[0], a);
+    STOREU(&S->h[4], b);
+    S->t[0] = ctr0;
+    S->t[1] = ctr1;
+}
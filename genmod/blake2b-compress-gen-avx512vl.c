@@ -0,0 +1,65 @@
+#define _MM_MALLOC_H_INCLUDED
+
+#include "blake2.h"
+#include "blake2-impl.h"
+
+# ifdef __GNUC__
+#  pragma GCC target("sse2")
+#  pragma GCC target("ssse3")
+#  pragma GCC target("sse4.1")
+#  pragma GCC target("avx2")
+#  pragma GCC target("avx512f")
+#  pragma GCC target("avx512vl")
+# endif
+
+# include <emmintrin.h>
+# include <immintrin.h>
+# include <smmintrin.h>
+# include <tmmintrin.h>
+
+# include "blake2b-config-avx512vl.h"
+# include "blake2b-round-avx512vl.h"
+
+static const uint64_t blake2b_IV[8] __aligned(32) = {
+    0x6a09e667f3bcc908ULL, 0xbb67ae8584caa73bULL, 0x3c6ef372fe94f82bULL,
+    0xa54ff53a5f1d36f1ULL, 0x510e527fade682d1ULL, 0x9b05688c2b3e6c1fULL,
+    0x1f83d9abfb41bd6bULL, 0x5be0cd19137e2179ULL
+};
+
+int blake2b_compress(struct blake2b_state *S, const uint8_t block[BLAKE2B_BLOCKBYTES])
+{
+    __m256i a = LOADU(&S->h[0]);
+    __m256i b = LOADU(&S->h[4]);
+    BLAKE2B_COMPRESS_V1(a, b, block, S->t[0], S->t[1], S->f[0], S->f[1]);
+    STOREU(&S->h[0], a);
+    STOREU(&S->h[4], b);
+
+    return 0;
+}
+
+/*
+ * Compress nblocks consecutive blocks, adding inc to the counter before each
+ * one. The finalization flags are taken from S as set by the caller. The
+ * chaining value and the counter are written back once at the end.
+ */
+void blake2b_compress_blocks(struct blake2b_state *S, const uint8_t *in,
+                             size_t nblocks, uint32_t inc)
+{
+    __m256i  a = LOADU(&S->h[0]);
+    __m256i  b = LOADU(&S->h[4]);
+    uint64_t ctr0 = S->t[0];
+    uint64_t ctr1 = S->t[1];
+    const uint64_t flag0 = S->f[0];
+    const uint64_t flag1 = S->f[1];
+
+    while (nblocks--) {
+        ctr0 += inc;
+        ctr1 += (ctr0 < inc);
+        BLAKE2B_COMPRESS_V1(a, b, in, ctr0, ctr1, flag0, flag1);
+        in += BLAKE2B_BLOCKBYTES;
+    }
+    STOREU(&S->h[0], a);
+    STOREU(&S->h[4], b);
+    S->t[0] = ctr0;
+    S->t[1] = ctr1;
+}
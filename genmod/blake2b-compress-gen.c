@@ -35,8 +35,9 @@ static const uint64_t blake2b_IV[8] =
   0x1f83d9abfb41bd6bULL, 0x5be0cd19137e2179ULL
 };
 
-asmlinkage
-void blake2b_compress(struct blake2b_state *S, const uint8_t block[BLAKE2B_BLOCKBYTES] )
+/* One block, the chaining value h[] stays in registers across calls */
+static __always_inline void blake2b_compress_block( __m128i h[4], __m128i t, __m128i f,
+                                                    const uint8_t block[BLAKE2B_BLOCKBYTES] )
 {
   __m128i row1l, row1h;
   __m128i row2l, row2h;
@@ -75,14 +76,14 @@ void blake2b_compress(struct blake2b_state *S, const uint8_t block[BLAKE2B_BLOCK
   const uint64_t m14 = load64(block + 14 * sizeof(uint64_t));
   const uint64_t m15 = load64(block + 15 * sizeof(uint64_t));
 #endif
-  row1l = LOADU( &S->h[0] );
-  row1h = LOADU( &S->h[2] );
-  row2l = LOADU( &S->h[4] );
-  row2h = LOADU( &S->h[6] );
+  row1l = h[0];
+  row1h = h[1];
+  row2l = h[2];
+  row2h = h[3];
   row3l = LOADU( &blake2b_IV[0] );
   row3h = LOADU( &blake2b_IV[2] );
-  row4l = _mm_xor_si128( LOADU( &blake2b_IV[4] ), LOADU( &S->t[0] ) );
-  row4h = _mm_xor_si128( LOADU( &blake2b_IV[6] ), LOADU( &S->f[0] ) );
+  row4l = _mm_xor_si128( LOADU( &blake2b_IV[4] ), t );
+  row4h = _mm_xor_si128( LOADU( &blake2b_IV[6] ), f );
   ROUND( 0 );
   ROUND( 1 );
   ROUND( 2 );
@@ -97,10 +98,59 @@ void blake2b_compress(struct blake2b_state *S, const uint8_t block[BLAKE2B_BLOCK
   ROUND( 11 );
   row1l = _mm_xor_si128( row3l, row1l );
   row1h = _mm_xor_si128( row3h, row1h );
-  STOREU( &S->h[0], _mm_xor_si128( LOADU( &S->h[0] ), row1l ) );
-  STOREU( &S->h[2], _mm_xor_si128( LOADU( &S->h[2] ), row1h ) );
+  h[0] = _mm_xor_si128( h[0], row1l );
+  h[1] = _mm_xor_si128( h[1], row1h );
   row2l = _mm_xor_si128( row4l, row2l );
   row2h = _mm_xor_si128( row4h, row2h );
-  STOREU( &S->h[4], _mm_xor_si128( LOADU( &S->h[4] ), row2l ) );
-  STOREU( &S->h[6], _mm_xor_si128( LOADU( &S->h[6] ), row2h ) );
+  h[2] = _mm_xor_si128( h[2], row2l );
+  h[3] = _mm_xor_si128( h[3], row2h );
+}
+
+asmlinkage
+void blake2b_compress(struct blake2b_state *S, const uint8_t block[BLAKE2B_BLOCKBYTES] )
+{
+  __m128i h[4];
+
+  h[0] = LOADU( &S->h[0] );
+  h[1] = LOADU( &S->h[2] );
+  h[2] = LOADU( &S->h[4] );
+  h[3] = LOADU( &S->h[6] );
+  blake2b_compress_block( h, LOADU( &S->t[0] ), LOADU( &S->f[0] ), block );
+  STOREU( &S->h[0], h[0] );
+  STOREU( &S->h[2], h[1] );
+  STOREU( &S->h[4], h[2] );
+  STOREU( &S->h[6], h[3] );
+}
+
+/*
+ * Compress nblocks consecutive blocks, adding inc to the counter before each
+ * one. The finalization flags are taken from S as set by the caller. The
+ * chaining value and the counter are written back once at the end.
+ */
+asmlinkage
+void blake2b_compress_blocks(struct blake2b_state *S, const uint8_t *in,
+                             size_t nblocks, uint32_t inc )
+{
+  const __m128i f = LOADU( &S->f[0] );
+  uint64_t t0 = S->t[0];
+  uint64_t t1 = S->t[1];
+  __m128i h[4];
+
+  h[0] = LOADU( &S->h[0] );
+  h[1] = LOADU( &S->h[2] );
+  h[2] = LOADU( &S->h[4] );
+  h[3] = LOADU( &S->h[6] );
+  while( nblocks-- )
+  {
+    t0 += inc;
+    t1 += ( t0 < inc );
+    blake2b_compress_block( h, _mm_set_epi64x( t1, t0 ), f, in );
+    in += BLAKE2B_BLOCKBYTES;
+  }
+  STOREU( &S->h[0], h[0] );
+  STOREU( &S->h[2], h[1] );
+  STOREU( &S->h[4], h[2] );
+  STOREU( &S->h[6], h[3] );
+  S->t[0] = t0;
+  S->t[1] = t1;
 }
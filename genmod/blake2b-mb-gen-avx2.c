@@ -0,0 +1,176 @@
+#define _MM_MALLOC_H_INCLUDED
+
+#include "blake2.h"
+#include "blake2-impl.h"
+
+# ifdef __GNUC__
+#  pragma GCC target("sse2")
+#  pragma GCC target("ssse3")
+#  pragma GCC target("sse4.1")
+#  pragma GCC target("avx2")
+# endif
+
+# include <emmintrin.h>
+# include <immintrin.h>
+
+# include "blake2b-config-avx2.h"
+
+/*
+ * 4-way multi-buffer compress, one message per 64-bit lane of a ymm
+ * register. The state is transposed so the G function runs on the 16 words
+ * of the work vector exactly like the scalar code, the message blocks of the
+ * lanes are transposed on load.
+ */
+
+#define LOADU(p) _mm256_loadu_si256((const __m256i *) (p))
+#define STOREU(p, r) _mm256_storeu_si256((__m256i *) (p), r)
+
+#define ADD(a, b) _mm256_add_epi64(a, b)
+#define XOR(a, b) _mm256_xor_si256(a, b)
+
+#define ROT32(x) _mm256_shuffle_epi32((x), _MM_SHUFFLE(2, 3, 0, 1))
+#define ROT24(x) _mm256_shuffle_epi8((x), r24)
+#define ROT16(x) _mm256_shuffle_epi8((x), r16)
+#define ROT63(x) _mm256_or_si256(_mm256_srli_epi64((x), 63), ADD((x), (x)))
+
+# include "blake2b-round-mb.h"
+
+/* Words 4k..4k+3 of the four lane blocks into m[4k..4k+3] */
+#define LOAD_MSG_TRANSPOSE(k)                                      \
+    do {                                                           \
+        const __m256i a = LOADU(block[0] + 32 * (k));              \
+        const __m256i b = LOADU(block[1] + 32 * (k));              \
+        const __m256i c = LOADU(block[2] + 32 * (k));              \
+        const __m256i d = LOADU(block[3] + 32 * (k));              \
+        const __m256i ab0 = _mm256_unpacklo_epi64(a, b);           \
+        const __m256i ab1 = _mm256_unpackhi_epi64(a, b);           \
+        const __m256i cd0 = _mm256_unpacklo_epi64(c, d);           \
+        const __m256i cd1 = _mm256_unpackhi_epi64(c, d);           \
+        m[4 * (k) + 0] = _mm256_permute2x128_si256(ab0, cd0, 0x20); \
+        m[4 * (k) + 1] = _mm256_permute2x128_si256(ab1, cd1, 0x20); \
+        m[4 * (k) + 2] = _mm256_permute2x128_si256(ab0, cd0, 0x31); \
+        m[4 * (k) + 3] = _mm256_permute2x128_si256(ab1, cd1, 0x31); \
+    } while (0)
+
+/*
+ * Compress one block for each of lanes 0-3, the counter and the last block
+ * flag are taken from S as set by the caller. Lanes not set in mask keep
+ * their chaining value, their block pointer must still be readable.
+ */
+void blake2b_compress_mb4(struct blake2b_mb_state *S,
+                          const uint8_t *const block[], uint32_t mask)
+{
+    const __m256i r16 = _mm256_setr_epi8(2, 3, 4, 5, 6, 7, 0, 1, 10, 11, 12, 13, 14, 15, 8, 9,
+                                         2, 3, 4, 5, 6, 7, 0, 1, 10, 11, 12, 13, 14, 15, 8, 9);
+    const __m256i r24 = _mm256_setr_epi8(3, 4, 5, 6, 7, 0, 1, 2, 11, 12, 13, 14, 15, 8, 9, 10,
+                                         3, 4, 5, 6, 7, 0, 1, 2, 11, 12, 13, 14, 15, 8, 9, 10);
+    const __m256i bits = _mm256_setr_epi64x(1, 2, 4, 8);
+    const __m256i lanes = _mm256_cmpeq_epi64(
+        _mm256_and_si256(_mm256_set1_epi64x(mask), bits), bits);
+    __m256i m[16];
+    __m256i v[16];
+    int i;
+
+    LOAD_MSG_TRANSPOSE(0);
+    LOAD_MSG_TRANSPOSE(1);
+    LOAD_MSG_TRANSPOSE(2);
+    LOAD_MSG_TRANSPOSE(3);
+
+    for (i = 0; i < 8; ++i)
+        v[i] = LOADU(&S->h[i][0]);
+    v[ 8] = _mm256_set1_epi64x(blake2b_IV[0]);
+    v[ 9] = _mm256_set1_epi64x(blake2b_IV[1]);
+    v[10] = _mm256_set1_epi64x(blake2b_IV[2]);
+    v[11] = _mm256_set1_epi64x(blake2b_IV[3]);
+    v[12] = XOR(_mm256_set1_epi64x(blake2b_IV[4]), LOADU(&S->t[0]));
+    v[13] = _mm256_set1_epi64x(blake2b_IV[5]);
+    v[14] = XOR(_mm256_set1_epi64x(blake2b_IV[6]), LOADU(&S->f[0]));
+    v[15] = _mm256_set1_epi64x(blake2b_IV[7]);
+
+    ROUND(0);
+    ROUND(1);
+    ROUND(2);
+    ROUND(3);
+    ROUND(4);
+    ROUND(5);
+    ROUND(6);
+    ROUND(7);
+    ROUND(8);
+    ROUND(9);
+    ROUND(10);
+    ROUND(11);
+
+    for (i = 0; i < 8; ++i) {
+        const __m256i h = LOADU(&S->h[i][0]);
+
+        STOREU(&S->h[i][0],
+               _mm256_blendv_epi8(h, XOR(h, XOR(v[i], v[i + 8])), lanes));
+    }
+}
+
+/*
+ * Compress nblocks consecutive blocks of one message into each lane set in
+ * mask, every message word is broadcast to all lanes. The counter of the
+ * lanes is advanced by the block size before each block, the chaining
+ * values and counters of the other lanes are not touched.
+ */
+void blake2b_compress_mb4_bcast(struct blake2b_mb_state *S,
+                                const uint8_t *in, size_t nblocks,
+                                uint32_t mask)
+{
+    const __m256i r16 = _mm256_setr_epi8(2, 3, 4, 5, 6, 7, 0, 1, 10, 11, 12, 13, 14, 15, 8, 9,
+                                         2, 3, 4, 5, 6, 7, 0, 1, 10, 11, 12, 13, 14, 15, 8, 9);
+    const __m256i r24 = _mm256_setr_epi8(3, 4, 5, 6, 7, 0, 1, 2, 11, 12, 13, 14, 15, 8, 9, 10,
+                                         3, 4, 5, 6, 7, 0, 1, 2, 11, 12, 13, 14, 15, 8, 9, 10);
+    const __m256i bits = _mm256_setr_epi64x(1, 2, 4, 8);
+    const __m256i lanes = _mm256_cmpeq_epi64(
+        _mm256_and_si256(_mm256_set1_epi64x(mask), bits), bits);
+    const __m256i inc = _mm256_set1_epi64x(BLAKE2B_BLOCKBYTES);
+    const __m256i f = LOADU(&S->f[0]);
+    __m256i t = LOADU(&S->t[0]);
+    __m256i h[8];
+    __m256i m[16];
+    __m256i v[16];
+    int i;
+
+    for (i = 0; i < 8; ++i)
+        h[i] = LOADU(&S->h[i][0]);
+
+    for (; nblocks; --nblocks, in += BLAKE2B_BLOCKBYTES) {
+        for (i = 0; i < 16; ++i)
+            m[i] = _mm256_set1_epi64x(load64(in + sizeof(uint64_t) * i));
+
+        t = ADD(t, inc);
+        for (i = 0; i < 8; ++i)
+            v[i] = h[i];
+        v[ 8] = _mm256_set1_epi64x(blake2b_IV[0]);
+        v[ 9] = _mm256_set1_epi64x(blake2b_IV[1]);
+        v[10] = _mm256_set1_epi64x(blake2b_IV[2]);
+        v[11] = _mm256_set1_epi64x(blake2b_IV[3]);
+        v[12] = XOR(_mm256_set1_epi64x(blake2b_IV[4]), t);
+        v[13] = _mm256_set1_epi64x(blake2b_IV[5]);
+        v[14] = XOR(_mm256_set1_epi64x(blake2b_IV[6]), f);
+        v[15] = _mm256_set1_epi64x(blake2b_IV[7]);
+
+        ROUND(0);
+        ROUND(1);
+        ROUND(2);
+        ROUND(3);
+        ROUND(4);
+        ROUND(5);
+        ROUND(6);
+        ROUND(7);
+        ROUND(8);
+        ROUND(9);
+        ROUND(10);
+        ROUND(11);
+
+        for (i = 0; i < 8; ++i)
+            h[i] = XOR(h[i], XOR(v[i], v[i + 8]));
+    }
+
+    for (i = 0; i < 8; ++i)
+        STOREU(&S->h[i][0],
+               _mm256_blendv_epi8(LOADU(&S->h[i][0]), h[i], lanes));
+    STOREU(&S->t[0], _mm256_blendv_epi8(LOADU(&S->t[0]), t, lanes));
+}
@@ -0,0 +1,181 @@
+#define _MM_MALLOC_H_INCLUDED
+
+#include "blake2.h"
+#include "blake2-impl.h"
+
+# ifdef __GNUC__
+#  pragma GCC target("sse2")
+#  pragma GCC target("ssse3")
+#  pragma GCC target("sse4.1")
+#  pragma GCC target("avx2")
+#  pragma GCC target("avx512f")
+# endif
+
+# include <emmintrin.h>
+# include <immintrin.h>
+
+# include "blake2b-config-avx512.h"
+
+/*
+ * 8-way multi-buffer compress, one message per 64-bit lane of a zmm
+ * register. Same structure as the AVX2 4-way code with native rotates, the
+ * lanes to update are selected by a mask register.
+ */
+
+#define LOADU(p) _mm512_loadu_si512((const void *) (p))
+#define STOREU(p, r) _mm512_storeu_si512((void *) (p), r)
+
+#define ADD(a, b) _mm512_add_epi64(a, b)
+#define XOR(a, b) _mm512_xor_si512(a, b)
+#define XOR3(a, b, c) _mm512_ternarylogic_epi64(a, b, c, 0x96)
+
+#define ROT32(x) _mm512_ror_epi64((x), 32)
+#define ROT24(x) _mm512_ror_epi64((x), 24)
+#define ROT16(x) _mm512_ror_epi64((x), 16)
+#define ROT63(x) _mm512_ror_epi64((x), 63)
+
+# include "blake2b-round-mb.h"
+
+/* Words 8k..8k+7 of the eight lane blocks into m[8k..8k+7] */
+#define LOAD_MSG_TRANSPOSE(k)                                      \
+    do {                                                           \
+        const __m512i r0 = LOADU(block[0] + 64 * (k));             \
+        const __m512i r1 = LOADU(block[1] + 64 * (k));             \
+        const __m512i r2 = LOADU(block[2] + 64 * (k));             \
+        const __m512i r3 = LOADU(block[3] + 64 * (k));             \
+        const __m512i r4 = LOADU(block[4] + 64 * (k));             \
+        const __m512i r5 = LOADU(block[5] + 64 * (k));             \
+        const __m512i r6 = LOADU(block[6] + 64 * (k));             \
+        const __m512i r7 = LOADU(block[7] + 64 * (k));             \
+        const __m512i t0 = _mm512_unpacklo_epi64(r0, r1);          \
+        const __m512i t1 = _mm512_unpackhi_epi64(r0, r1);          \
+        const __m512i t2 = _mm512_unpacklo_epi64(r2, r3);          \
+        const __m512i t3 = _mm512_unpackhi_epi64(r2, r3);          \
+        const __m512i t4 = _mm512_unpacklo_epi64(r4, r5);          \
+        const __m512i t5 = _mm512_unpackhi_epi64(r4, r5);          \
+        const __m512i t6 = _mm512_unpacklo_epi64(r6, r7);          \
+        const __m512i t7 = _mm512_unpackhi_epi64(r6, r7);          \
+        const __m512i u0 = _mm512_shuffle_i64x2(t0, t2, 0x88);     \
+        const __m512i u1 = _mm512_shuffle_i64x2(t0, t2, 0xdd);     \
+        const __m512i u2 = _mm512_shuffle_i64x2(t1, t3, 0x88);     \
+        const __m512i u3 = _mm512_shuffle_i64x2(t1, t3, 0xdd);     \
+        const __m512i u4 = _mm512_shuffle_i64x2(t4, t6, 0x88);     \
+        const __m512i u5 = _mm512_shuffle_i64x2(t4, t6, 0xdd);     \
+        const __m512i u6 = _mm512_shuffle_i64x2(t5, t7, 0x88);     \
+        const __m512i u7 = _mm512_shuffle_i64x2(t5, t7, 0xdd);     \
+        m[8 * (k) + 0] = _mm512_shuffle_i64x2(u0, u4, 0x88);       \
+        m[8 * (k) + 1] = _mm512_shuffle_i64x2(u2, u6, 0x88);       \
+        m[8 * (k) + 2] = _mm512_shuffle_i64x2(u1, u5, 0x88);       \
+        m[8 * (k) + 3] = _mm512_shuffle_i64x2(u3, u7, 0x88);       \
+        m[8 * (k) + 4] = _mm512_shuffle_i64x2(u0, u4, 0xdd);       \
+        m[8 * (k) + 5] = _mm512_shuffle_i64x2(u2, u6, 0xdd);       \
+        m[8 * (k) + 6] = _mm512_shuffle_i64x2(u1, u5, 0xdd);       \
+        m[8 * (k) + 7] = _mm512_shuffle_i64x2(u3, u7, 0xdd);       \
+    } while (0)
+
+/*
+ * Compress one block for each of lanes 0-7, the counter and the last block
+ * flag are taken from S as set by the caller. Lanes not set in mask keep
+ * their chaining value, their block pointer must still be readable.
+ */
+void blake2b_compress_mb8(struct blake2b_mb_state *S,
+                          const uint8_t *const block[], uint32_t mask)
+{
+    const __mmask8 lanes = (__mmask8)mask;
+    __m512i m[16];
+    __m512i v[16];
+    int i;
+
+    LOAD_MSG_TRANSPOSE(0);
+    LOAD_MSG_TRANSPOSE(1);
+
+    for (i = 0; i < 8; ++i)
+        v[i] = LOADU(&S->h[i][0]);
+    v[ 8] = _mm512_set1_epi64(blake2b_IV[0]);
+    v[ 9] = _mm512_set1_epi64(blake2b_IV[1]);
+    v[10] = _mm512_set1_epi64(blake2b_IV[2]);
+    v[11] = _mm512_set1_epi64(blake2b_IV[3]);
+    v[12] = XOR(_mm512_set1_epi64(blake2b_IV[4]), LOADU(&S->t[0]));
+    v[13] = _mm512_set1_epi64(blake2b_IV[5]);
+    v[14] = XOR(_mm512_set1_epi64(blake2b_IV[6]), LOADU(&S->f[0]));
+    v[15] = _mm512_set1_epi64(blake2b_IV[7]);
+
+    ROUND(0);
+    ROUND(1);
+    ROUND(2);
+    ROUND(3);
+    ROUND(4);
+    ROUND(5);
+    ROUND(6);
+    ROUND(7);
+    ROUND(8);
+    ROUND(9);
+    ROUND(10);
+    ROUND(11);
+
+    for (i = 0; i < 8; ++i) {
+        const __m512i h = LOADU(&S->h[i][0]);
+
+        _mm512_mask_storeu_epi64(&S->h[i][0], lanes, XOR3(h, v[i], v[i + 8]));
+    }
+}
+
+/*
+ * Compress nblocks consecutive blocks of one message into each lane set in
+ * mask, every message word is broadcast to all lanes. The counter of the
+ * lanes is advanced by the block size before each block, the chaining
+ * values and counters of the other lanes are not touched.
+ */
+void blake2b_compress_mb8_bcast(struct blake2b_mb_state *S,
+                                const uint8_t *in, size_t nblocks,
+                                uint32_t mask)
+{
+    const __mmask8 lanes = (__mmask8)mask;
+    const __m512i inc = _mm512_set1_epi64(BLAKE2B_BLOCKBYTES);
+    const __m512i f = LOADU(&S->f[0]);
+    __m512i t = LOADU(&S->t[0]);
+    __m512i h[8];
+    __m512i m[16];
+    __m512i v[16];
+    int i;
+
+    for (i = 0; i < 8; ++i)
+        h[i] = LOADU(&S->h[i][0]);
+
+    for (; nblocks; --nblocks, in += BLAKE2B_BLOCKBYTES) {
+        for (i = 0; i < 16; ++i)
+            m[i] = _mm512_set1_epi64(load64(in + sizeof(uint64_t) * i));
+
+        t = ADD(t, inc);
+        for (i = 0; i < 8; ++i)
+            v[i] = h[i];
+        v[ 8] = _mm512_set1_epi64(blake2b_IV[0]);
+        v[ 9] = _mm512_set1_epi64(blake2b_IV[1]);
+        v[10] = _mm512_set1_epi64(blake2b_IV[2]);
+        v[11] = _mm512_set1_epi64(blake2b_IV[3]);
+        v[12] = XOR(_mm512_set1_epi64(blake2b_IV[4]), t);
+        v[13] = _mm512_set1_epi64(blake2b_IV[5]);
+        v[14] = XOR(_mm512_set1_epi64(blake2b_IV[6]), f);
+        v[15] = _mm512_set1_epi64(blake2b_IV[7]);
+
+        ROUND(0);
+        ROUND(1);
+        ROUND(2);
+        ROUND(3);
+        ROUND(4);
+        ROUND(5);
+        ROUND(6);
+        ROUND(7);
+        ROUND(8);
+        ROUND(9);
+        ROUND(10);
+        ROUND(11);
+
+        for (i = 0; i < 8; ++i)
+            h[i] = XOR3(h[i], v[i], v[i + 8]);
+    }
+
+    for (i = 0; i < 8; ++i)
+        _mm512_mask_storeu_epi64(&S->h[i][0], lanes, h[i]);
+    _mm512_mask_storeu_epi64(&S->t[0], lanes, t);
+}
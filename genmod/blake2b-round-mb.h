@@ -0,0 +1,55 @@
+#ifndef blake2b_round_mb_H
+#define blake2b_round_mb_H
+
+/*
+ * Multi-buffer rounds, one message per lane and the work vector v[16] and
+ * message m[16] hold one word of every lane each. The includer defines ADD,
+ * XOR and ROT32/24/16/63 for its vector type.
+ */
+
+static const uint64_t blake2b_IV[8] = {
+    0x6a09e667f3bcc908ULL, 0xbb67ae8584caa73bULL, 0x3c6ef372fe94f82bULL,
+    0xa54ff53a5f1d36f1ULL, 0x510e527fade682d1ULL, 0x9b05688c2b3e6c1fULL,
+    0x1f83d9abfb41bd6bULL, 0x5be0cd19137e2179ULL
+};
+
+static const uint8_t blake2b_sigma[12][16] = {
+    {  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 15 },
+    { 14, 10,  4,  8,  9, 15, 13,  6,  1, 12,  0,  2, 11,  7,  5,  3 },
+    { 11,  8, 12,  0,  5,  2, 15, 13, 10, 14,  3,  6,  7,  1,  9,  4 },
+    {  7,  9,  3,  1, 13, 12, 11, 14,  2,  6,  5, 10,  4,  0, 15,  8 },
+    {  9,  0,  5,  7,  2,  4, 10, 15, 14,  1, 11, 12,  6,  8,  3, 13 },
+    {  2, 12,  6, 10,  0, 11,  8,  3,  4, 13,  7,  5, 15, 14,  1,  9 },
+    { 12,  5,  1, 15, 14, 13,  4, 10,  0,  7,  6,  3,  9,  2,  8, 11 },
+    { 13, 11,  7, 14, 12,  1,  3,  9,  5,  0, 15,  4,  8,  6,  2, 10 },
+    {  6, 15, 14,  9, 11,  3,  0,  8, 12,  2, 13,  7,  1,  4, 10,  5 },
+    { 10,  2,  8,  4,  7,  6,  1,  5, 15, 11,  9, 14,  3, 12, 13,  0 },
+    {  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 15 },
+    { 14, 10,  4,  8,  9, 15, 13,  6,  1, 12,  0,  2, 11,  7,  5,  3 }
+};
+
+#define G(r, i, a, b, c, d)                                  \
+    do {                                                     \
+        a = ADD(ADD(a, b), m[blake2b_sigma[r][2 * i + 0]]); \
+        d = ROT32(XOR(d, a));                                \
+        c = ADD(c, d);                                       \
+        b = ROT24(XOR(b, c));                                \
+        a = ADD(ADD(a, b), m[blake2b_sigma[r][2 * i + 1]]); \
+        d = ROT16(XOR(d, a));                                \
+        c = ADD(c, d);                                       \
+        b = ROT63(XOR(b, c));                                \
+    } while (0)
+
+#define ROUND(r)                                  \
+    do {                                          \
+        G(r, 0, v[0], v[4], v[ 8], v[12]);        \
+        G(r, 1, v[1], v[5], v[ 9], v[13]);        \
+        G(r, 2, v[2], v[6], v[10], v[14]);        \
+        G(r, 3, v[3], v[7], v[11], v[15]);        \
+        G(r, 4, v[0], v[5], v[10], v[15]);        \
+        G(r, 5, v[1], v[6], v[11], v[12]);        \
+        G(r, 6, v[2], v[7], v[ 8], v[13]);        \
+        G(r, 7, v[3], v[4], v[ 9], v[14]);        \
+    } while (0)
+
+#endif
@@ -0,0 +1,11 @@
+#define _MM_MALLOC_H_INCLUDED
+
+# ifdef __GNUC__
+#  pragma GCC target("sse2")
+#  pragma GCC target("sse4.1")
+#  pragma GCC target("avx")
+#endif
+
+#include "blake2s-config-avx.h"
+#include "blake2s-round.h"
+#include "blake2s-compress-gen.c"
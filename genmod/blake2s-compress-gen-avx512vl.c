@@ -0,0 +1,13 @@
+#define _MM_MALLOC_H_INCLUDED
+
+# ifdef __GNUC__
+#  pragma GCC target("sse2")
+#  pragma GCC target("sse4.1")
+#  pragma GCC target("avx")
+#  pragma GCC target("avx512f")
+#  pragma GCC target("avx512vl")
+#endif
+
+#include "blake2s-config-avx512vl.h"
+#include "blake2s-round.h"
+#include "blake2s-compress-gen.c"
@@ -0,0 +1,10 @@
+#define _MM_MALLOC_H_INCLUDED
+
+# ifdef __GNUC__
+#  pragma GCC target("sse2")
+#  pragma GCC target("ssse3")
+#endif
+
+#include "blake2s-config-ssse3.h"
+#include "blake2s-round.h"
+#include "blake2s-compress-gen.c"
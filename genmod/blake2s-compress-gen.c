@@ -0,0 +1,116 @@
+#include <linux/types.h>
+#include <linux/string.h>
+#include <linux/linkage.h>
+
+#include "blake2.h"
+#include "blake2-impl.h"
+
+#ifndef BLAKE2_CONFIG_H
+#error "include some blake2-config"
+#endif
+
+#ifndef ROUND
+#error "No ROUND defined"
+#endif
+
+#include <emmintrin.h>
+#if defined(HAVE_SSSE3)
+#include <tmmintrin.h>
+#endif
+#if defined(HAVE_SSE41)
+#include <smmintrin.h>
+#endif
+#if defined(HAVE_AVX)
+#include <immintrin.h>
+#endif
+
+static const uint32_t blake2s_IV[8] =
+{
+  0x6A09E667UL, 0xBB67AE85UL, 0x3C6EF372UL, 0xA54FF53AUL,
+  0x510E527FUL, 0x9B05688CUL, 0x1F83D9ABUL, 0x5BE0CD19UL
+};
+
+/*
+ * One block, the chaining value h[] stays in registers across calls. The
+ * counter and the finalization flags are the last row of the IV, tf.
+ */
+static __always_inline void blake2s_compress_block( __m128i h[2], __m128i tf,
+                                                    const uint8_t block[BLAKE2S_BLOCKBYTES] )
+{
+  __m128i row1, row2, row3, row4;
+  __m128i buf;
+#if defined(HAVE_SSSE3) && !defined(HAVE_AVX512VL)
+  const __m128i r8 = _mm_set_epi8( 12, 15, 14, 13, 8, 11, 10, 9, 4, 7, 6, 5, 0, 3, 2, 1 );
+  const __m128i r16 = _mm_set_epi8( 13, 12, 15, 14, 9, 8, 11, 10, 5, 4, 7, 6, 1, 0, 3, 2 );
+#endif
+#if defined(HAVE_SSE41)
+  const __m128i m0 = LOADU( block +  00 );
+  const __m128i m1 = LOADU( block +  16 );
+  const __m128i m2 = LOADU( block +  32 );
+  const __m128i m3 = LOADU( block +  48 );
+  __m128i t0, t1, t2, t3;
+#else
+  const uint32_t  m0 = load32(block +  0 * sizeof(uint32_t));
+  const uint32_t  m1 = load32(block +  1 * sizeof(uint32_t));
+  const uint32_t  m2 = load32(block +  2 * sizeof(uint32_t));
+  const uint32_t  m3 = load32(block +  3 * sizeof(uint32_t));
+  const uint32_t  m4 = load32(block +  4 * sizeof(uint32_t));
+  const uint32_t  m5 = load32(block +  5 * sizeof(uint32_t));
+  const uint32_t  m6 = load32(block +  6 * sizeof(uint32_t));
+  const uint32_t  m7 = load32(block +  7 * sizeof(uint32_t));
+  const uint32_t  m8 = load32(block +  8 * sizeof(uint32_t));
+  const uint32_t  m9 = load32(block +  9 * sizeof(uint32_t));
+  const uint32_t m10 = load32(block + 10 * sizeof(uint32_t));
+  const uint32_t m11 = load32(block + 11 * sizeof(uint32_t));
+  const uint32_t m12 = load32(block + 12 * sizeof(uint32_t));
+  const uint32_t m13 = load32(block + 13 * sizeof(uint32_t));
+  const uint32_t m14 = load32(block + 14 * sizeof(uint32_t));
+  const uint32_t m15 = load32(block + 15 * sizeof(uint32_t));
+#endif
+  row1 = h[0];
+  row2 = h[1];
+  row3 = LOADU( &blake2s_IV[0] );
+  row4 = _mm_xor_si128( LOADU( &blake2s_IV[4] ), tf );
+  ROUND( 0 );
+  ROUND( 1 );
+  ROUND( 2 );
+  ROUND( 3 );
+  ROUND( 4 );
+  ROUND( 5 );
+  ROUND( 6 );
+  ROUND( 7 );
+  ROUND( 8 );
+  ROUND( 9 );
+  h[0] = XOR3( h[0], row1, row3 );
+  h[1] = XOR3( h[1], row2, row4 );
+}
+
+/*
+ * Compress nblocks consecutive blocks, adding inc to the counter before each
+ * one. The finalization flags are taken from S as set by the caller. The
+ * chaining value and the counter are written back once at the end.
+ */
+asmlinkage
+void blake2s_compress_blocks(struct blake2s_state *S, const uint8_t *in,
+                             size_t nblocks, uint32_t inc )
+{
+  const uint32_t f0 = S->f[0];
+  const uint32_t f1 = S->f[1];
+  uint32_t t0 = S->t[0];
+  uint32_t t1 = S->t[1];
+  __m128i h[2];
+
+  h[0] = LOADU( &S->h[0] );
+  h[1] = LOADU( &S->h[4] );
+  while( nblocks-- )
+  {
+    t0 += inc;
+    t1 += ( t0 < inc );
+    blake2s_compress_block( h, _mm_set_epi32( f1, f0, t1, t0 ), in );
+    in += BLAKE2S_BLOCKBYTES;
+  }
+  STOREU( &S->h[0], h[0] );
+  STOREU( &S->h[4], h[1] );
+  S->t[0] = t0;
+  S->t[1] = t1;
+}
@@ -0,0 +1,273 @@
+/*
+   BLAKE2 reference source code package - optimized C implementations
+
+   Copyright 2012, Samuel Neves <sneves@dei.uc.pt>.  You may use this under the
+   terms of the CC0, the OpenSSL Licence, or the Apache Public License 2.0, at
+   your option.  The terms of these licenses can be found at:
+
+   - CC0 1.0 Universal : http://creativecommons.org/publicdomain/zero/1.0
+   - OpenSSL license   : https://www.openssl.org/source/license.html
+   - Apache 2.0        : http://www.apache.org/licenses/LICENSE-2.0
+
+   More information about the BLAKE2 hash function can be found at
+   https://blake2.net.
+*/
+#ifndef BLAKE2S_LOAD_SSE41_H
+#define BLAKE2S_LOAD_SSE41_H
+
+/*
+ * The block is loaded as four vectors m0-m3 and each message vector is put
+ * together from them with pshufd and pblendw, or shufps where one half
+ * comes from each of two vectors. Uses the temporaries t0-t3.
+ */
+
+#define LOAD_MSG_0_1(buf) \
+buf = TOI(_mm_shuffle_ps(TOF(m0), TOF(m1), _MM_SHUFFLE(2,0,2,0)));
+
+#define LOAD_MSG_0_2(buf) \
+buf = TOI(_mm_shuffle_ps(TOF(m0), TOF(m1), _MM_SHUFFLE(3,1,3,1)));
+
+#define LOAD_MSG_0_3(buf) \
+t0 = _mm_shuffle_epi32(m3, _MM_SHUFFLE(0,2,1,2)); \
+t1 = _mm_shuffle_epi32(m2, _MM_SHUFFLE(3,2,0,0)); \
+buf = _mm_blend_epi16(t0, t1, 0x3C);
+
+#define LOAD_MSG_0_4(buf) \
+t0 = _mm_shuffle_epi32(m3, _MM_SHUFFLE(1,2,1,3)); \
+t1 = _mm_shuffle_epi32(m2, _MM_SHUFFLE(3,3,1,0)); \
+buf = _mm_blend_epi16(t0, t1, 0x3C);
+
+#define LOAD_MSG_1_1(buf) \
+t0 = _mm_shuffle_epi32(m3, _MM_SHUFFLE(1,2,1,2)); \
+t1 = _mm_shuffle_epi32(m1, _MM_SHUFFLE(3,2,0,0)); \
+t2 = _mm_shuffle_epi32(m2, _MM_SHUFFLE(3,1,1,0)); \
+buf = _mm_blend_epi16(t0, t1, 0x0C); \
+buf = _mm_blend_epi16(buf, t2, 0x30);
+
+#define LOAD_MSG_1_2(buf) \
+t0 = _mm_shuffle_epi32(m2, _MM_SHUFFLE(3,2,0,2)); \
+t1 = _mm_shuffle_epi32(m3, _MM_SHUFFLE(3,3,1,0)); \
+t2 = _mm_shuffle_epi32(m1, _MM_SHUFFLE(2,2,1,0)); \
+buf = _mm_blend_epi16(t0, t1, 0x30); \
+buf = _mm_blend_epi16(buf, t2, 0xC0);
+
+#define LOAD_MSG_1_3(buf) \
+t0 = _mm_shuffle_epi32(m1, _MM_SHUFFLE(3,2,1,1)); \
+t1 = _mm_shuffle_epi32(m0, _MM_SHUFFLE(3,0,1,0)); \
+buf = _mm_blend_epi16(t0, t1, 0x3C); \
+buf = _mm_blend_epi16(buf, m2, 0xC0);
+
+#define LOAD_MSG_1_4(buf) \
+t0 = _mm_shuffle_epi32(m0, _MM_SHUFFLE(3,2,1,3)); \
+t1 = _mm_shuffle_epi32(m3, _MM_SHUFFLE(3,2,0,0)); \
+buf = _mm_blend_epi16(t0, t1, 0x0C); \
+buf = _mm_blend_epi16(buf, m1, 0xC0);
+
+#define LOAD_MSG_2_1(buf) \
+t0 = _mm_shuffle_epi32(m2, _MM_SHUFFLE(3,2,1,3)); \
+t1 = _mm_shuffle_epi32(m3, _MM_SHUFFLE(3,2,0,0)); \
+t2 = _mm_shuffle_epi32(m1, _MM_SHUFFLE(3,1,1,0)); \
+buf = _mm_blend_epi16(t0, t1, 0xCC); \
+buf = _mm_blend_epi16(buf, t2, 0x30);
+
+#define LOAD_MSG_2_2(buf) \
+t1 = _mm_shuffle_epi32(m0, _MM_SHUFFLE(3,2,0,0)); \
+t2 = _mm_shuffle_epi32(m3, _MM_SHUFFLE(1,2,1,0)); \
+buf = _mm_blend_epi16(m2, t1, 0x3C); \
+buf = _mm_blend_epi16(buf, t2, 0xC0);
+
+#define LOAD_MSG_2_3(buf) \
+t0 = _mm_shuffle_epi32(m2, _MM_SHUFFLE(3,2,2,1)); \
+t1 = _mm_shuffle_epi32(m0, _MM_SHUFFLE(3,3,1,0)); \
+buf = _mm_blend_epi16(t0, t1, 0x30); \
+buf = _mm_blend_epi16(buf, m1, 0xC0);
+
+#define LOAD_MSG_2_4(buf) \
+t1 = _mm_shuffle_epi32(m3, _MM_SHUFFLE(3,2,2,0)); \
+t2 = _mm_shuffle_epi32(m0, _MM_SHUFFLE(1,2,1,0)); \
+buf = _mm_blend_epi16(m1, t1, 0x0C); \
+buf = _mm_blend_epi16(buf, t2, 0xC0);
+
+#define LOAD_MSG_3_1(buf) \
+t0 = _mm_shuffle_epi32(m1, _MM_SHUFFLE(3,2,1,3)); \
+t1 = _mm_shuffle_epi32(m0, _MM_SHUFFLE(3,2,3,0)); \
+t2 = _mm_shuffle_epi32(m3, _MM_SHUFFLE(3,1,1,0)); \
+buf = _mm_blend_epi16(t0, t1, 0x0C); \
+buf = _mm_blend_epi16(buf, t2, 0x30); \
+buf = _mm_blend_epi16(buf, m2, 0xC0);
+
+#define LOAD_MSG_3_2(buf) \
+t0 = _mm_shuffle_epi32(m2, _MM_SHUFFLE(3,2,1,1)); \
+t2 = _mm_shuffle_epi32(m3, _MM_SHUFFLE(2,0,1,0)); \
+buf = _mm_blend_epi16(t0, m0, 0x0C); \
+buf = _mm_blend_epi16(buf, t2, 0xF0);
+
+#define LOAD_MSG_3_3(buf) \
+t0 = _mm_shuffle_epi32(m3, _MM_SHUFFLE(3,2,1,3)); \
+t1 = _mm_shuffle_epi32(m0, _MM_SHUFFLE(3,2,2,0)); \
+t2 = _mm_shuffle_epi32(m1, _MM_SHUFFLE(0,1,1,0)); \
+buf = _mm_blend_epi16(t0, t1, 0x0C); \
+buf = _mm_blend_epi16(buf, t2, 0xF0);
+
+#define LOAD_MSG_3_4(buf) \
+t1 = _mm_shuffle_epi32(m1, _MM_SHUFFLE(3,2,2,0)); \
+t2 = _mm_shuffle_epi32(m0, _MM_SHUFFLE(0,2,1,0)); \
+buf = _mm_blend_epi16(m2, t1, 0x0C); \
+buf = _mm_blend_epi16(buf, t2, 0xC0);
+
+#define LOAD_MSG_4_1(buf) \
+t0 = _mm_shuffle_epi32(m2, _MM_SHUFFLE(2,2,1,1)); \
+buf = _mm_blend_epi16(t0, m1, 0x0C); \
+buf = _mm_blend_epi16(buf, m0, 0x30);
+
+#define LOAD_MSG_4_2(buf) \
+t1 = _mm_shuffle_epi32(m1, _MM_SHUFFLE(3,0,3,0)); \
+buf = _mm_blend_epi16(m0, t1, 0x3C); \
+buf = _mm_blend_epi16(buf, m3, 0xC0);
+
+#define LOAD_MSG_4_3(buf) \
+t0 = _mm_shuffle_epi32(m0, _MM_SHUFFLE(3,2,1,3)); \
+t1 = _mm_shuffle_epi32(m3, _MM_SHUFFLE(3,2,2,0)); \
+t2 = _mm_shuffle_epi32(m2, _MM_SHUFFLE(3,3,1,0)); \
+t3 = _mm_shuffle_epi32(m1, _MM_SHUFFLE(2,2,1,0)); \
+buf = _mm_blend_epi16(t0, t1, 0x0C); \
+buf = _mm_blend_epi16(buf, t2, 0x30); \
+buf = _mm_blend_epi16(buf, t3, 0xC0);
+
+#define LOAD_MSG_4_4(buf) \
+t0 = _mm_shuffle_epi32(m3, _MM_SHUFFLE(3,0,1,1)); \
+t2 = _mm_shuffle_epi32(m2, _MM_SHUFFLE(0,2,1,0)); \
+buf = _mm_blend_epi16(t0, m0, 0x0C); \
+buf = _mm_blend_epi16(buf, t2, 0xC0);
+
+#define LOAD_MSG_5_1(buf) \
+t0 = _mm_shuffle_epi32(m0, _MM_SHUFFLE(3,0,1,2)); \
+t1 = _mm_shuffle_epi32(m1, _MM_SHUFFLE(3,2,2,0)); \
+t2 = _mm_shuffle_epi32(m2, _MM_SHUFFLE(0,2,1,0)); \
+buf = _mm_blend_epi16(t0, t1, 0x0C); \
+buf = _mm_blend_epi16(buf, t2, 0xC0);
+
+#define LOAD_MSG_5_2(buf) \
+t1 = _mm_shuffle_epi32(m2, _MM_SHUFFLE(3,3,2,0)); \
+buf = _mm_blend_epi16(m3, t1, 0x3C); \
+buf = _mm_blend_epi16(buf, m0, 0xC0);
+
+#define LOAD_MSG_5_3(buf) \
+t0 = _mm_shuffle_epi32(m0, _MM_SHUFFLE(3,2,1,1)); \
+t1 = _mm_shuffle_epi32(m1, _MM_SHUFFLE(3,3,0,0)); \
+buf = _mm_blend_epi16(t0, t1, 0x3C); \
+buf = _mm_blend_epi16(buf, m3, 0xC0);
+
+#define LOAD_MSG_5_4(buf) \
+t0 = _mm_shuffle_epi32(m2, _MM_SHUFFLE(3,2,1,1)); \
+t1 = _mm_shuffle_epi32(m3, _MM_SHUFFLE(2,2,1,0)); \
+t2 = _mm_shuffle_epi32(m1, _MM_SHUFFLE(3,1,1,0)); \
+buf = _mm_blend_epi16(t0, t1, 0xCC); \
+buf = _mm_blend_epi16(buf, t2, 0x30);
+
+#define LOAD_MSG_6_1(buf) \
+t2 = _mm_shuffle_epi32(m1, _MM_SHUFFLE(0,2,1,0)); \
+buf = _mm_blend_epi16(m3, m0, 0x0C); \
+buf = _mm_blend_epi16(buf, t2, 0xC0);
+
+#define LOAD_MSG_6_2(buf) \
+t0 = _mm_shuffle_epi32(m1, _MM_SHUFFLE(3,2,1,1)); \
+t1 = _mm_shuffle_epi32(m3, _MM_SHUFFLE(3,1,3,0)); \
+t2 = _mm_shuffle_epi32(m2, _MM_SHUFFLE(2,2,1,0)); \
+buf = _mm_blend_epi16(t0, t1, 0x3C); \
+buf = _mm_blend_epi16(buf, t2, 0xC0);
+
+#define LOAD_MSG_6_3(buf) \
+t0 = _mm_shuffle_epi32(m2, _MM_SHUFFLE(1,2,1,0)); \
+t1 = _mm_shuffle_epi32(m0, _MM_SHUFFLE(3,2,0,0)); \
+buf = _mm_blend_epi16(t0, t1, 0x0C); \
+buf = _mm_blend_epi16(buf, m1, 0x30);
+
+#define LOAD_MSG_6_4(buf) \
+t0 = _mm_shuffle_epi32(m2, _MM_SHUFFLE(3,2,1,3)); \
+t1 = _mm_shuffle_epi32(m1, _MM_SHUFFLE(3,2,3,0)); \
+t2 = _mm_shuffle_epi32(m0, _MM_SHUFFLE(2,3,1,0)); \
+buf = _mm_blend_epi16(t0, t1, 0x0C); \
+buf = _mm_blend_epi16(buf, t2, 0xF0);
+
+#define LOAD_MSG_7_1(buf) \
+t0 = _mm_shuffle_epi32(m3, _MM_SHUFFLE(3,0,1,1)); \
+t1 = _mm_shuffle_epi32(m1, _MM_SHUFFLE(3,2,3,0)); \
+buf = _mm_blend_epi16(t0, t1, 0x0C); \
+buf = _mm_blend_epi16(buf, m0, 0xC0);
+
+#define LOAD_MSG_7_2(buf) \
+t0 = _mm_shuffle_epi32(m2, _MM_SHUFFLE(1,2,1,3)); \
+t1 = _mm_shuffle_epi32(m3, _MM_SHUFFLE(3,2,2,0)); \
+t2 = _mm_shuffle_epi32(m0, _MM_SHUFFLE(3,1,1,0)); \
+buf = _mm_blend_epi16(t0, t1, 0x0C); \
+buf = _mm_blend_epi16(buf, t2, 0x30);
+
+#define LOAD_MSG_7_3(buf) \
+t0 = _mm_shuffle_epi32(m0, _MM_SHUFFLE(3,2,1,2)); \
+t2 = _mm_shuffle_epi32(m3, _MM_SHUFFLE(3,3,1,0)); \
+t3 = _mm_shuffle_epi32(m2, _MM_SHUFFLE(0,2,1,0)); \
+buf = _mm_blend_epi16(t0, m1, 0x0C); \
+buf = _mm_blend_epi16(buf, t2, 0x30); \
+buf = _mm_blend_epi16(buf, t3, 0xC0);
+
+#define LOAD_MSG_7_4(buf) \
+t0 = _mm_shuffle_epi32(m2, _MM_SHUFFLE(3,2,1,2)); \
+t1 = _mm_shuffle_epi32(m0, _MM_SHUFFLE(3,2,0,0)); \
+t2 = _mm_shuffle_epi32(m1, _MM_SHUFFLE(2,0,1,0)); \
+buf = _mm_blend_epi16(t0, t1, 0x0C); \
+buf = _mm_blend_epi16(buf, t2, 0xF0);
+
+#define LOAD_MSG_8_1(buf) \
+t0 = _mm_shuffle_epi32(m1, _MM_SHUFFLE(3,2,1,2)); \
+t1 = _mm_shuffle_epi32(m3, _MM_SHUFFLE(3,2,2,0)); \
+t2 = _mm_shuffle_epi32(m2, _MM_SHUFFLE(3,3,1,0)); \
+t3 = _mm_shuffle_epi32(m0, _MM_SHUFFLE(0,2,1,0)); \
+buf = _mm_blend_epi16(t0, t1, 0x0C); \
+buf = _mm_blend_epi16(buf, t2, 0x30); \
+buf = _mm_blend_epi16(buf, t3, 0xC0);
+
+#define LOAD_MSG_8_2(buf) \
+t0 = _mm_shuffle_epi32(m3, _MM_SHUFFLE(3,2,1,3)); \
+t1 = _mm_shuffle_epi32(m2, _MM_SHUFFLE(0,2,1,0)); \
+t2 = _mm_shuffle_epi32(m0, _MM_SHUFFLE(3,3,1,0)); \
+buf = _mm_blend_epi16(t0, t1, 0xCC); \
+buf = _mm_blend_epi16(buf, t2, 0x30);
+
+#define LOAD_MSG_8_3(buf) \
+t0 = _mm_shuffle_epi32(m2, _MM_SHUFFLE(3,2,1,2)); \
+t1 = _mm_shuffle_epi32(m3, _MM_SHUFFLE(3,1,0,0)); \
+t2 = _mm_shuffle_epi32(m0, _MM_SHUFFLE(1,2,1,0)); \
+buf = _mm_blend_epi16(t0, t1, 0x3C); \
+buf = _mm_blend_epi16(buf, t2, 0xC0);
+
+#define LOAD_MSG_8_4(buf) \
+t0 = _mm_shuffle_epi32(m1, _MM_SHUFFLE(0,3,1,1)); \
+t1 = _mm_shuffle_epi32(m0, _MM_SHUFFLE(3,2,2,0)); \
+buf = _mm_blend_epi16(t0, t1, 0x0C);
+
+#define LOAD_MSG_9_1(buf) \
+t0 = _mm_shuffle_epi32(m2, _MM_SHUFFLE(3,2,0,2)); \
+t1 = _mm_shuffle_epi32(m1, _MM_SHUFFLE(3,3,1,0)); \
+t2 = _mm_shuffle_epi32(m0, _MM_SHUFFLE(1,2,1,0)); \
+buf = _mm_blend_epi16(t0, t1, 0x30); \
+buf = _mm_blend_epi16(buf, t2, 0xC0);
+
+#define LOAD_MSG_9_2(buf) \
+t0 = _mm_shuffle_epi32(m0, _MM_SHUFFLE(3,2,1,2)); \
+t1 = _mm_shuffle_epi32(m1, _MM_SHUFFLE(1,2,0,0)); \
+buf = _mm_blend_epi16(t0, t1, 0xFC);
+
+#define LOAD_MSG_9_3(buf) \
+t0 = _mm_shuffle_epi32(m3, _MM_SHUFFLE(3,2,3,1)); \
+t1 = _mm_shuffle_epi32(m2, _MM_SHUFFLE(3,1,1,0)); \
+buf = _mm_blend_epi16(t0, t1, 0x30); \
+buf = _mm_blend_epi16(buf, m0, 0xC0);
+
+#define LOAD_MSG_9_4(buf) \
+t1 = _mm_shuffle_epi32(m2, _MM_SHUFFLE(3,2,3,0)); \
+t2 = _mm_shuffle_epi32(m3, _MM_SHUFFLE(0,2,1,0)); \
+buf = _mm_blend_epi16(m0, t1, 0x0C); \
+buf = _mm_blend_epi16(buf, t2, 0xF0);
+
+#endif
@@ -0,0 +1,195 @@
+#define _MM_MALLOC_H_INCLUDED
+
+#include "blake2.h"
+#include "blake2-impl.h"
+
+# ifdef __GNUC__
+#  pragma GCC target("sse2")
+#  pragma GCC target("ssse3")
+#  pragma GCC target("sse4.1")
+#  pragma GCC target("avx2")
+# endif
+
+# include <emmintrin.h>
+# include <immintrin.h>
+
+# include "blake2s-config-avx2.h"
+
+/*
+ * 8-way multi-buffer BLAKE2s compress, one message per 32-bit lane of a ymm
+ * register. Same structure as the BLAKE2b 4-way code, the message blocks of
+ * the lanes are transposed 8x8 words at a time.
+ */
+
+#define LOADU(p) _mm256_loadu_si256((const __m256i *) (p))
+#define STOREU(p, r) _mm256_storeu_si256((__m256i *) (p), r)
+
+#define ADD(a, b) _mm256_add_epi32(a, b)
+#define XOR(a, b) _mm256_xor_si256(a, b)
+
+#define ROT16(x) _mm256_shuffle_epi8((x), r16)
+#define ROT12(x) _mm256_or_si256(_mm256_srli_epi32((x), 12), _mm256_slli_epi32((x), 20))
+#define ROT8(x) _mm256_shuffle_epi8((x), r8)
+#define ROT7(x) _mm256_or_si256(_mm256_srli_epi32((x), 7), _mm256_slli_epi32((x), 25))
+
+# include "blake2s-round-mb.h"
+
+/* Words 8k..8k+7 of the eight lane blocks into m[8k..8k+7] */
+#define LOAD_MSG_TRANSPOSE(k)                                        \
+    do {                                                             \
+        const __m256i r0 = LOADU(block[0] + 32 * (k));               \
+        const __m256i r1 = LOADU(block[1] + 32 * (k));               \
+        const __m256i r2 = LOADU(block[2] + 32 * (k));               \
+        const __m256i r3 = LOADU(block[3] + 32 * (k));               \
+        const __m256i r4 = LOADU(block[4] + 32 * (k));               \
+        const __m256i r5 = LOADU(block[5] + 32 * (k));               \
+        const __m256i r6 = LOADU(block[6] + 32 * (k));               \
+        const __m256i r7 = LOADU(block[7] + 32 * (k));               \
+        const __m256i t0 = _mm256_unpacklo_epi32(r0, r1);            \
+        const __m256i t1 = _mm256_unpackhi_epi32(r0, r1);            \
+        const __m256i t2 = _mm256_unpacklo_epi32(r2, r3);            \
+        const __m256i t3 = _mm256_unpackhi_epi32(r2, r3);            \
+        const __m256i t4 = _mm256_unpacklo_epi32(r4, r5);            \
+        const __m256i t5 = _mm256_unpackhi_epi32(r4, r5);            \
+        const __m256i t6 = _mm256_unpacklo_epi32(r6, r7);            \
+        const __m256i t7 = _mm256_unpackhi_epi32(r6, r7);            \
+        const __m256i u0 = _mm256_unpacklo_epi64(t0, t2);            \
+        const __m256i u1 = _mm256_unpackhi_epi64(t0, t2);            \
+        const __m256i u2 = _mm256_unpacklo_epi64(t1, t3);            \
+        const __m256i u3 = _mm256_unpackhi_epi64(t1, t3);            \
+        const __m256i u4 = _mm256_unpacklo_epi64(t4, t6);            \
+        const __m256i u5 = _mm256_unpackhi_epi64(t4, t6);            \
+        const __m256i u6 = _mm256_unpacklo_epi64(t5, t7);            \
+        const __m256i u7 = _mm256_unpackhi_epi64(t5, t7);            \
+        m[8 * (k) + 0] = _mm256_permute2x128_si256(u0, u4, 0x20);    \
+        m[8 * (k) + 1] = _mm256_permute2x128_si256(u1, u5, 0x20);    \
+        m[8 * (k) + 2] = _mm256_permute2x128_si256(u2, u6, 0x20);    \
+        m[8 * (k) + 3] = _mm256_permute2x128_si256(u3, u7, 0x20);    \
+        m[8 * (k) + 4] = _mm256_permute2x128_si256(u0, u4, 0x31);    \
+        m[8 * (k) + 5] = _mm256_permute2x128_si256(u1, u5, 0x31);    \
+        m[8 * (k) + 6] = _mm256_permute2x128_si256(u2, u6, 0x31);    \
+        m[8 * (k) + 7] = _mm256_permute2x128_si256(u3, u7, 0x31);    \
+    } while (0)
+
+/*
+ * Compress one block for each of lanes 0-7, the counter and the last block
+ * flag are taken from S as set by the caller. Lanes not set in mask keep
+ * their chaining value, their block pointer must still be readable.
+ */
+void blake2s_compress_mb8(struct blake2s_mb_state *S,
+                          const uint8_t *const block[], uint32_t mask)
+{
+    const __m256i r16 = _mm256_setr_epi8(2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13,
+                                         2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13);
+    const __m256i r8 = _mm256_setr_epi8(1, 2, 3, 0, 5, 6, 7, 4, 9, 10, 11, 8, 13, 14, 15, 12,
+                                        1, 2, 3, 0, 5, 6, 7, 4, 9, 10, 11, 8, 13, 14, 15, 12);
+    const __m256i bits = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+    const __m256i lanes = _mm256_cmpeq_epi32(
+        _mm256_and_si256(_mm256_set1_epi32(mask), bits), bits);
+    __m256i m[16];
+    __m256i v[16];
+    int i;
+
+    LOAD_MSG_TRANSPOSE(0);
+    LOAD_MSG_TRANSPOSE(1);
+
+    for (i = 0; i < 8; ++i)
+        v[i] = LOADU(&S->h[i][0]);
+    v[ 8] = _mm256_set1_epi32(blake2s_IV[0]);
+    v[ 9] = _mm256_set1_epi32(blake2s_IV[1]);
+    v[10] = _mm256_set1_epi32(blake2s_IV[2]);
+    v[11] = _mm256_set1_epi32(blake2s_IV[3]);
+    v[12] = XOR(_mm256_set1_epi32(blake2s_IV[4]), LOADU(&S->t[0][0]));
+    v[13] = XOR(_mm256_set1_epi32(blake2s_IV[5]), LOADU(&S->t[1][0]));
+    v[14] = XOR(_mm256_set1_epi32(blake2s_IV[6]), LOADU(&S->f[0]));
+    v[15] = _mm256_set1_epi32(blake2s_IV[7]);
+
+    ROUND(0);
+    ROUND(1);
+    ROUND(2);
+    ROUND(3);
+    ROUND(4);
+    ROUND(5);
+    ROUND(6);
+    ROUND(7);
+    ROUND(8);
+    ROUND(9);
+
+    for (i = 0; i < 8; ++i) {
+        const __m256i h = LOADU(&S->h[i][0]);
+
+        STOREU(&S->h[i][0],
+               _mm256_blendv_epi8(h, XOR(h, XOR(v[i], v[i + 8])), lanes));
+    }
+}
+
+/*
+ * Compress nblocks consecutive blocks of one message into each lane set in
+ * mask, every message word is broadcast to all lanes. The counter of the
+ * lanes is advanced by the block size before each block, the chaining
+ * values and counters of the other lanes are not touched.
+ */
+void blake2s_compress_mb8_bcast(struct blake2s_mb_state *S,
+                                const uint8_t *in, size_t nblocks,
+                                uint32_t mask)
+{
+    const __m256i r16 = _mm256_setr_epi8(2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13,
+                                         2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13);
+    const __m256i r8 = _mm256_setr_epi8(1, 2, 3, 0, 5, 6, 7, 4, 9, 10, 11, 8, 13, 14, 15, 12,
+                                        1, 2, 3, 0, 5, 6, 7, 4, 9, 10, 11, 8, 13, 14, 15, 12);
+    const __m256i bits = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+    const __m256i lanes = _mm256_cmpeq_epi32(
+        _mm256_and_si256(_mm256_set1_epi32(mask), bits), bits);
+    const __m256i inc = _mm256_set1_epi32(BLAKE2S_BLOCKBYTES);
+    /* Unsigned t0 < inc after the add is the carry, compared with bias */
+    const __m256i bias = _mm256_set1_epi32(0x80000000);
+    const __m256i f = LOADU(&S->f[0]);
+    __m256i t0 = LOADU(&S->t[0][0]);
+    __m256i t1 = LOADU(&S->t[1][0]);
+    __m256i h[8];
+    __m256i m[16];
+    __m256i v[16];
+    int i;
+
+    for (i = 0; i < 8; ++i)
+        h[i] = LOADU(&S->h[i][0]);
+
+    for (; nblocks; --nblocks, in += BLAKE2S_BLOCKBYTES) {
+        for (i = 0; i < 16; ++i)
+            m[i] = _mm256_set1_epi32(load32(in + sizeof(uint32_t) * i));
+
+        t0 = ADD(t0, inc);
+        t1 = _mm256_sub_epi32(t1, _mm256_cmpgt_epi32(XOR(inc, bias),
+                                                     XOR(t0, bias)));
+        for (i = 0; i < 8; ++i)
+            v[i] = h[i];
+        v[ 8] = _mm256_set1_epi32(blake2s_IV[0]);
+        v[ 9] = _mm256_set1_epi32(blake2s_IV[1]);
+        v[10] = _mm256_set1_epi32(blake2s_IV[2]);
+        v[11] = _mm256_set1_epi32(blake2s_IV[3]);
+        v[12] = XOR(_mm256_set1_epi32(blake2s_IV[4]), t0);
+        v[13] = XOR(_mm256_set1_epi32(blake2s_IV[5]), t1);
+        v[14] = XOR(_mm256_set1_epi32(blake2s_IV[6]), f);
+        v[15] = _mm256_set1_epi32(blake2s_IV[7]);
+
+        ROUND(0);
+        ROUND(1);
+        ROUND(2);
+        ROUND(3);
+        ROUND(4);
+        ROUND(5);
+        ROUND(6);
+        ROUND(7);
+        ROUND(8);
+        ROUND(9);
+
+        for (i = 0; i < 8; ++i)
+            h[i] = XOR(h[i], XOR(v[i], v[i + 8]));
+    }
+
+    for (i = 0; i < 8; ++i)
+        STOREU(&S->h[i][0],
+               _mm256_blendv_epi8(LOADU(&S->h[i][0]), h[i], lanes));
+    STOREU(&S->t[0][0], _mm256_blendv_epi8(LOADU(&S->t[0][0]), t0, lanes));
+    STOREU(&S->t[1][0], _mm256_blendv_epi8(LOADU(&S->t[1][0]), t1, lanes));
+}
@@ -0,0 +1,185 @@
+#define _MM_MALLOC_H_INCLUDED
+
+#include "blake2.h"
+#include "blake2-impl.h"
+
+# ifdef __GNUC__
+#  pragma GCC target("sse2")
+#  pragma GCC target("ssse3")
+#  pragma GCC target("sse4.1")
+#  pragma GCC target("avx2")
+#  pragma GCC target("avx512f")
+# endif
+
+# include <emmintrin.h>
+# include <immintrin.h>
+
+# include "blake2s-config-avx512.h"
+
+/*
+ * 16-way multi-buffer BLAKE2s compress, one message per 32-bit lane of a zmm
+ * register. Same structure as the AVX2 8-way code with native rotates, the
+ * lanes to update are selected by a mask register.
+ */
+
+#define LOADU(p) _mm512_loadu_si512((const void *) (p))
+#define STOREU(p, r) _mm512_storeu_si512((void *) (p), r)
+
+#define ADD(a, b) _mm512_add_epi32(a, b)
+#define XOR(a, b) _mm512_xor_si512(a, b)
+#define XOR3(a, b, c) _mm512_ternarylogic_epi32(a, b, c, 0x96)
+
+#define ROT16(x) _mm512_ror_epi32((x), 16)
+#define ROT12(x) _mm512_ror_epi32((x), 12)
+#define ROT8(x) _mm512_ror_epi32((x), 8)
+#define ROT7(x) _mm512_ror_epi32((x), 7)
+
+# include "blake2s-round-mb.h"
+
+/*
+ * The blocks of lanes 4q..4q+3 interleaved, 128-bit lane j of w[q][k] holds
+ * word 4j+k of those four lanes
+ */
+#define LOAD_MSG_INTERLEAVE(q)                                     \
+    do {                                                           \
+        const __m512i r0 = LOADU(block[4 * (q) + 0]);              \
+        const __m512i r1 = LOADU(block[4 * (q) + 1]);              \
+        const __m512i r2 = LOADU(block[4 * (q) + 2]);              \
+        const __m512i r3 = LOADU(block[4 * (q) + 3]);              \
+        const __m512i t0 = _mm512_unpacklo_epi32(r0, r1);          \
+        const __m512i t1 = _mm512_unpackhi_epi32(r0, r1);          \
+        const __m512i t2 = _mm512_unpacklo_epi32(r2, r3);          \
+        const __m512i t3 = _mm512_unpackhi_epi32(r2, r3);          \
+        w[q][0] = _mm512_unpacklo_epi64(t0, t2);                   \
+        w[q][1] = _mm512_unpackhi_epi64(t0, t2);                   \
+        w[q][2] = _mm512_unpacklo_epi64(t1, t3);                   \
+        w[q][3] = _mm512_unpackhi_epi64(t1, t3);                   \
+    } while (0)
+
+/* Gather 128-bit lane j of the four groups into m[4j+k] */
+#define LOAD_MSG_TRANSPOSE(k)                                      \
+    do {                                                           \
+        const __m512i x0 = _mm512_shuffle_i32x4(w[0][k], w[1][k], 0x44); \
+        const __m512i x1 = _mm512_shuffle_i32x4(w[0][k], w[1][k], 0xee); \
+        const __m512i y0 = _mm512_shuffle_i32x4(w[2][k], w[3][k], 0x44); \
+        const __m512i y1 = _mm512_shuffle_i32x4(w[2][k], w[3][k], 0xee); \
+        m[ 0 + (k)] = _mm512_shuffle_i32x4(x0, y0, 0x88);          \
+        m[ 4 + (k)] = _mm512_shuffle_i32x4(x0, y0, 0xdd);          \
+        m[ 8 + (k)] = _mm512_shuffle_i32x4(x1, y1, 0x88);          \
+        m[12 + (k)] = _mm512_shuffle_i32x4(x1, y1, 0xdd);          \
+    } while (0)
+
+/*
+ * Compress one block for each of lanes 0-15, the counter and the last block
+ * flag are taken from S as set by the caller. Lanes not set in mask keep
+ * their chaining value, their block pointer must still be readable.
+ */
+void blake2s_compress_mb16(struct blake2s_mb_state *S,
+                           const uint8_t *const block[], uint32_t mask)
+{
+    const __mmask16 lanes = (__mmask16)mask;
+    __m512i w[4][4];
+    __m512i m[16];
+    __m512i v[16];
+    int i;
+
+    LOAD_MSG_INTERLEAVE(0);
+    LOAD_MSG_INTERLEAVE(1);
+    LOAD_MSG_INTERLEAVE(2);
+    LOAD_MSG_INTERLEAVE(3);
+    LOAD_MSG_TRANSPOSE(0);
+    LOAD_MSG_TRANSPOSE(1);
+    LOAD_MSG_TRANSPOSE(2);
+    LOAD_MSG_TRANSPOSE(3);
+
+    for (i = 0; i < 8; ++i)
+        v[i] = LOADU(&S->h[i][0]);
+    v[ 8] = _mm512_set1_epi32(blake2s_IV[0]);
+    v[ 9] = _mm512_set1_epi32(blake2s_IV[1]);
+    v[10] = _mm512_set1_epi32(blake2s_IV[2]);
+    v[11] = _mm512_set1_epi32(blake2s_IV[3]);
+    v[12] = XOR(_mm512_set1_epi32(blake2s_IV[4]), LOADU(&S->t[0][0]));
+    v[13] = XOR(_mm512_set1_epi32(blake2s_IV[5]), LOADU(&S->t[1][0]));
+    v[14] = XOR(_mm512_set1_epi32(blake2s_IV[6]), LOADU(&S->f[0]));
+    v[15] = _mm512_set1_epi32(blake2s_IV[7]);
+
+    ROUND(0);
+    ROUND(1);
+    ROUND(2);
+    ROUND(3);
+    ROUND(4);
+    ROUND(5);
+    ROUND(6);
+    ROUND(7);
+    ROUND(8);
+    ROUND(9);
+
+    for (i = 0; i < 8; ++i) {
+        const __m512i h = LOADU(&S->h[i][0]);
+
+        _mm512_mask_storeu_epi32(&S->h[i][0], lanes, XOR3(h, v[i], v[i + 8]));
+    }
+}
+
+/*
+ * Compress nblocks consecutive blocks of one message into each lane set in
+ * mask, every message word is broadcast to all lanes. The counter of the
+ * lanes is advanced by the block size before each block, the chaining
+ * values and counters of the other lanes are not touched.
+ */
+void blake2s_compress_mb16_bcast(struct blake2s_mb_state *S,
+                                 const uint8_t *in, size_t nblocks,
+                                 uint32_t mask)
+{
+    const __mmask16 lanes = (__mmask16)mask;
+    const __m512i inc = _mm512_set1_epi32(BLAKE2S_BLOCKBYTES);
+    const __m512i one = _mm512_set1_epi32(1);
+    const __m512i f = LOADU(&S->f[0]);
+    __m512i t0 = LOADU(&S->t[0][0]);
+    __m512i t1 = LOADU(&S->t[1][0]);
+    __m512i h[8];
+    __m512i m[16];
+    __m512i v[16];
+    int i;
+
+    for (i = 0; i < 8; ++i)
+        h[i] = LOADU(&S->h[i][0]);
+
+    for (; nblocks; --nblocks, in += BLAKE2S_BLOCKBYTES) {
+        for (i = 0; i < 16; ++i)
+            m[i] = _mm512_set1_epi32(load32(in + sizeof(uint32_t) * i));
+
+        t0 = ADD(t0, inc);
+        t1 = _mm512_mask_add_epi32(t1, _mm512_cmplt_epu32_mask(t0, inc),
+                                   t1, one);
+        for (i = 0; i < 8; ++i)
+            v[i] = h[i];
+        v[ 8] = _mm512_set1_epi32(blake2s_IV[0]);
+        v[ 9] = _mm512_set1_epi32(blake2s_IV[1]);
+        v[10] = _mm512_set1_epi32(blake2s_IV[2]);
+        v[11] = _mm512_set1_epi32(blake2s_IV[3]);
+        v[12] = XOR(_mm512_set1_epi32(blake2s_IV[4]), t0);
+        v[13] = XOR(_mm512_set1_epi32(blake2s_IV[5]), t1);
+        v[14] = XOR(_mm512_set1_epi32(blake2s_IV[6]), f);
+        v[15] = _mm512_set1_epi32(blake2s_IV[7]);
+
+        ROUND(0);
+        ROUND(1);
+        ROUND(2);
+        ROUND(3);
+        ROUND(4);
+        ROUND(5);
+        ROUND(6);
+        ROUND(7);
+        ROUND(8);
+        ROUND(9);
+
+        for (i = 0; i < 8; ++i)
+            h[i] = XOR3(h[i], v[i], v[i + 8]);
+    }
+
+    for (i = 0; i < 8; ++i)
+        _mm512_mask_storeu_epi32(&S->h[i][0], lanes, h[i]);
+    _mm512_mask_storeu_epi32(&S->t[0][0], lanes, t0);
+    _mm512_mask_storeu_epi32(&S->t[1][0], lanes, t1);
+}